@@ -0,0 +1,162 @@
+//
+//  ClockTests.cpp
+//  VoodooI2CGoodix
+//
+//  Created by agent on 10/17/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include "VoodooI2CGoodixClock.hpp"
+#include "TestHelpers.hpp"
+
+#define MS  1000000ULL
+
+struct Firing {
+    VoodooI2CGoodixTimerID timer;
+    UInt64 at;
+};
+
+// Records each timer as it fires, and optionally re-arms the lift timer once like the lift watchdog does
+struct Recorder {
+    VoodooI2CGoodixClock* clock;
+    Firing firings[16];
+    int count;
+    UInt64 rearmLiftAt;
+
+    static void fired(void* target, VoodooI2CGoodixTimerID timer) {
+        Recorder* recorder = (Recorder*)target;
+        recorder->firings[recorder->count].timer = timer;
+        recorder->firings[recorder->count].at = recorder->clock->getNanoseconds();
+        recorder->count++;
+        if (timer == kGoodixTimerLift && recorder->rearmLiftAt) {
+            recorder->clock->setDeadline(kGoodixTimerLift, recorder->rearmLiftAt);
+            recorder->rearmLiftAt = 0;
+        }
+    }
+};
+
+// A clock that counts how often it's asked to reprogram its wakeup
+class CountingClock : public VoodooI2CGoodixClock {
+ public:
+    int wakeups = 0;
+    UInt64 wakeup = GOODIX_CLOCK_NEVER;
+    UInt64 now = 0;
+
+    UInt64 getNanoseconds() override {
+        return now;
+    }
+
+    void wakeUp(UInt64 time) {
+        now = time;
+        fireDue(time);
+    }
+
+ protected:
+    void setWakeup(UInt64 deadline) override {
+        wakeups++;
+        wakeup = deadline;
+    }
+};
+
+static void testVirtualClockFiresInDeadlineOrder() {
+    VoodooI2CGoodixVirtualClock clock(10 * MS);
+    Recorder recorder = {&clock, {}, 0, 0};
+    clock.setAction(&Recorder::fired, &recorder);
+
+    clock.setDeadline(kGoodixTimerClick, 40 * MS);
+    clock.setDeadline(kGoodixTimerLift, 30 * MS);
+    clock.advance(15 * MS);
+    CHECK_EQUAL(recorder.count, 0);
+    CHECK_EQUAL(clock.getNanoseconds(), 25 * MS);
+
+    clock.advanceTo(100 * MS);
+    CHECK_EQUAL(recorder.count, 2);
+    CHECK_EQUAL(recorder.firings[0].timer, kGoodixTimerLift);
+    CHECK_EQUAL(recorder.firings[0].at, 30 * MS);
+    CHECK_EQUAL(recorder.firings[1].timer, kGoodixTimerClick);
+    CHECK_EQUAL(recorder.firings[1].at, 40 * MS);
+    CHECK_EQUAL(clock.getNanoseconds(), 100 * MS);
+    CHECK(!clock.isArmed(kGoodixTimerLift));
+
+    // The clock never goes backwards
+    clock.advanceTo(50 * MS);
+    CHECK_EQUAL(clock.getNanoseconds(), 100 * MS);
+}
+
+static void testVirtualClockHandlesRearming() {
+    VoodooI2CGoodixVirtualClock clock;
+    Recorder recorder = {&clock, {}, 0, 70 * MS};
+    clock.setAction(&Recorder::fired, &recorder);
+
+    clock.setDeadline(kGoodixTimerLift, 50 * MS);
+    clock.setDeadline(kGoodixTimerClick, 60 * MS);
+    clock.advanceTo(100 * MS);
+    CHECK_EQUAL(recorder.count, 3);
+    CHECK_EQUAL(recorder.firings[1].timer, kGoodixTimerClick);
+    CHECK_EQUAL(recorder.firings[2].timer, kGoodixTimerLift);
+    CHECK_EQUAL(recorder.firings[2].at, 70 * MS);
+}
+
+static void testCancel() {
+    VoodooI2CGoodixVirtualClock clock;
+    Recorder recorder = {&clock, {}, 0, 0};
+    clock.setAction(&Recorder::fired, &recorder);
+
+    clock.setDeadline(kGoodixTimerClick, 10 * MS);
+    clock.cancel(kGoodixTimerClick);
+    clock.cancel(kGoodixTimerLift);
+    clock.advance(20 * MS);
+    CHECK_EQUAL(recorder.count, 0);
+}
+
+static void testReset() {
+    VoodooI2CGoodixVirtualClock clock(100 * MS);
+    Recorder recorder = {&clock, {}, 0, 0};
+    clock.setAction(&Recorder::fired, &recorder);
+
+    // Starting over at an earlier time drops the timers armed before
+    clock.setDeadline(kGoodixTimerLift, 150 * MS);
+    clock.reset(10 * MS);
+    CHECK_EQUAL(clock.getNanoseconds(), 10 * MS);
+    CHECK(!clock.isArmed(kGoodixTimerLift));
+    clock.advanceTo(200 * MS);
+    CHECK_EQUAL(recorder.count, 0);
+}
+
+static void testSingleWakeup() {
+    CountingClock clock;
+    Recorder recorder = {&clock, {}, 0, 300};
+    clock.setAction(&Recorder::fired, &recorder);
+
+    clock.setDeadline(kGoodixTimerLift, 100);
+    clock.setDeadline(kGoodixTimerClick, 200);
+    clock.setDeadline(kGoodixTimerClick, 250);
+    CHECK_EQUAL(clock.wakeups, 1);
+    CHECK_EQUAL(clock.wakeup, 100);
+
+    // The lift timer re-arms itself while it fires, the wakeup is only programmed once after
+    clock.wakeUp(100);
+    CHECK_EQUAL(clock.wakeups, 2);
+    CHECK_EQUAL(clock.wakeup, 250);
+
+    clock.cancel(kGoodixTimerClick);
+    CHECK_EQUAL(clock.wakeup, 300);
+    clock.cancel(kGoodixTimerLift);
+    CHECK(clock.wakeup == GOODIX_CLOCK_NEVER);
+    CHECK_EQUAL(clock.wakeups, 4);
+
+    // A wakeup that comes early fires nothing and waits again
+    clock.setDeadline(kGoodixTimerLift, 500);
+    clock.wakeUp(400);
+    CHECK_EQUAL(recorder.count, 1);
+    CHECK_EQUAL(clock.wakeup, 500);
+}
+
+int main() {
+    testVirtualClockFiresInDeadlineOrder();
+    testVirtualClockHandlesRearming();
+    testCancel();
+    testReset();
+    testSingleWakeup();
+    return TEST_RESULT();
+}
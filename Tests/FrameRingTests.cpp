@@ -0,0 +1,115 @@
+//
+//  FrameRingTests.cpp
+//  VoodooI2CGoodix
+//
+//  Created by agent on 10/17/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include <thread>
+#include "VoodooI2CGoodixFrameRing.hpp"
+#include "goodix.h"
+#include "TestHelpers.hpp"
+
+#define STRESS_ITEMS    1000000
+
+// Big enough that a slot copied while it's being written would show up as a mismatch
+struct Item {
+    uint64_t sequence;
+    uint64_t words[15];
+};
+
+static void fill(Item& item, uint64_t sequence) {
+    item.sequence = sequence;
+    for (int i = 0; i < 15; i++) {
+        item.words[i] = sequence * 31 + i;
+    }
+}
+
+static bool isConsistent(const Item& item) {
+    for (int i = 0; i < 15; i++) {
+        if (item.words[i] != item.sequence * 31 + i) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void testEmptyAndFull() {
+    VoodooI2CGoodixFrameRing<int, 4> ring;
+    int value = -1;
+    CHECK(!ring.pop(value));
+    CHECK(ring.peek() == NULL);
+
+    for (int i = 0; i < 4; i++) {
+        CHECK(ring.push(i));
+    }
+    CHECK(!ring.push(4));
+    CHECK_EQUAL(ring.count(), 4);
+
+    CHECK(ring.peek() && *ring.peek() == 0);
+    CHECK(ring.pop(value));
+    CHECK_EQUAL(value, 0);
+    CHECK(ring.push(4));
+    CHECK_EQUAL(ring.count(), 4);
+}
+
+static void testWraparound() {
+    VoodooI2CGoodixFrameRing<int, 8> ring;
+    int value = -1;
+    for (int i = 0; i < 1000; i++) {
+        CHECK(ring.push(i));
+        CHECK(ring.push(i + 1000));
+        CHECK(ring.pop(value));
+        CHECK_EQUAL(value, i);
+        CHECK(ring.pop(value));
+        CHECK_EQUAL(value, i + 1000);
+    }
+    CHECK_EQUAL(ring.count(), 0);
+}
+
+static void testStress() {
+    static VoodooI2CGoodixFrameRing<Item, GOODIX_FRAME_RING_SIZE> ring;
+    uint64_t fullPushes = 0;
+
+    std::thread producer([&fullPushes] {
+        Item item;
+        for (uint64_t sequence = 0; sequence < STRESS_ITEMS; sequence++) {
+            fill(item, sequence);
+            while (!ring.push(item)) {
+                fullPushes++;
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    // The consumer peeks before popping half the time, the item it peeked has to be the one it pops
+    uint64_t expected = 0;
+    uint64_t errors = 0;
+    Item item;
+    while (expected < STRESS_ITEMS) {
+        const Item* next = (expected & 1) ? ring.peek() : NULL;
+        uint64_t peeked = next ? next->sequence : 0;
+        if (!ring.pop(item)) {
+            std::this_thread::yield();
+            continue;
+        }
+        if (item.sequence != expected || !isConsistent(item) || (next && peeked != expected)) {
+            errors++;
+        }
+        expected++;
+    }
+    producer.join();
+
+    CHECK_EQUAL(errors, 0);
+    CHECK_EQUAL(ring.count(), 0);
+    printf("Moved %d items through a ring of %d, the producer found it full %llu times\n",
+           STRESS_ITEMS, GOODIX_FRAME_RING_SIZE, (unsigned long long)fullPushes);
+}
+
+int main() {
+    testEmptyAndFull();
+    testWraparound();
+    testStress();
+    return TEST_RESULT();
+}
@@ -0,0 +1,49 @@
+//
+//  GestureMachineBenchmark.cpp
+//  VoodooI2CGoodix
+//
+//  Created by agent on 10/17/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include <chrono>
+#include <stdio.h>
+#include "GestureSequences.hpp"
+
+#define ITERATIONS  2000000
+
+struct Sequence {
+    const char* name;
+    const GestureStep* steps;
+    int length;
+};
+
+static const Sequence sequences[] = {
+    {"tap", tapSequence, SEQUENCE_LENGTH(tapSequence)},
+    {"drag", dragSequence, SEQUENCE_LENGTH(dragSequence)},
+    {"hold", holdSequence, SEQUENCE_LENGTH(holdSequence)},
+    {"right click drag", rightClickDragSequence, SEQUENCE_LENGTH(rightClickDragSequence)}
+};
+
+int main() {
+    VoodooI2CGoodixGestureMachine machine;
+
+    for (const Sequence& sequence : sequences) {
+        // Sum the commands so the work can't be optimised away
+        uint64_t commands = 0;
+        uint64_t start = 0;
+
+        auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < ITERATIONS; i++) {
+            for (int j = 0; j < sequence.length; j++) {
+                commands += runStep(machine, sequence.steps[j], start);
+            }
+            start += 5000;
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        double nanoseconds = std::chrono::duration<double, std::nano>(end - begin).count();
+        printf("%-18s %6.2f ns per step (%llu commands)\n", sequence.name, nanoseconds / ((double)ITERATIONS * sequence.length), (unsigned long long)commands);
+    }
+    return 0;
+}
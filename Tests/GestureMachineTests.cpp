@@ -0,0 +1,218 @@
+//
+//  GestureMachineTests.cpp
+//  VoodooI2CGoodix
+//
+//  Created by agent on 10/17/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include "GestureSequences.hpp"
+#include "TestHelpers.hpp"
+
+// The commands of the last step, as a list to compare against
+struct Commands {
+    VoodooI2CGoodixGestureOutput outputs[GOODIX_GESTURE_MAX_OUTPUTS];
+    int count;
+};
+
+static Commands step(VoodooI2CGoodixGestureMachine& machine, const GestureStep& input, uint64_t start = 0) {
+    Commands commands;
+    commands.count = runStep(machine, input, start);
+    for (int i = 0; i < commands.count; i++) {
+        commands.outputs[i] = machine.getOutputs()[i];
+    }
+    return commands;
+}
+
+static bool isDispatch(const VoodooI2CGoodixGestureOutput& output, uint8_t button, int x, int y) {
+    return output.command == kGoodixGestureDispatch && output.button == button && output.x == x && output.y == y;
+}
+
+static void testTap() {
+    VoodooI2CGoodixGestureMachine machine;
+
+    Commands commands = step(machine, tapSequence[0]);
+    CHECK_EQUAL(machine.getState(), kGoodixGesturePressed);
+    CHECK_EQUAL(commands.count, 2);
+    CHECK(isDispatch(commands.outputs[0], kGoodixGestureButtonNone, 500, 300));
+    CHECK_EQUAL(commands.outputs[1].command, kGoodixGestureArmHold);
+
+    commands = step(machine, tapSequence[1]);
+    CHECK_EQUAL(machine.getLastEvent(), kGoodixGestureStill);
+    CHECK_EQUAL(commands.count, 2);
+    CHECK_EQUAL(commands.outputs[1].command, kGoodixGestureArmClick);
+
+    step(machine, tapSequence[2]);
+    commands = step(machine, tapSequence[3]);
+    CHECK_EQUAL(machine.getState(), kGoodixGestureIdle);
+    CHECK_EQUAL(commands.count, 2);
+    CHECK_EQUAL(commands.outputs[0].command, kGoodixGestureCancelHold);
+    CHECK_EQUAL(commands.outputs[1].command, kGoodixGestureLiftHover);
+
+    // The click goes where the finger went down
+    commands = step(machine, tapSequence[4]);
+    CHECK_EQUAL(commands.count, 2);
+    CHECK(isDispatch(commands.outputs[0], kGoodixGestureButtonLeft, 500, 300));
+    CHECK(isDispatch(commands.outputs[1], kGoodixGestureButtonNone, 500, 300));
+}
+
+static void testDoubleClick() {
+    VoodooI2CGoodixGestureMachine machine;
+    for (int i = 0; i < SEQUENCE_LENGTH(tapSequence); i++) {
+        step(machine, tapSequence[i]);
+    }
+
+    // A second tap close to the first, within DOUBLE_CLICK_TIME of it, clicks twice where the first one was
+    Commands commands;
+    for (int i = 0; i < SEQUENCE_LENGTH(tapSequence); i++) {
+        GestureStep input = tapSequence[i];
+        input.x += 10;
+        commands = step(machine, input, 200);
+    }
+    CHECK_EQUAL(commands.count, 4);
+    CHECK(isDispatch(commands.outputs[0], kGoodixGestureButtonLeft, 500, 300));
+    CHECK(isDispatch(commands.outputs[3], kGoodixGestureButtonNone, 500, 300));
+
+    // Too late for a double click
+    for (int i = 0; i < SEQUENCE_LENGTH(tapSequence); i++) {
+        commands = step(machine, tapSequence[i], 2000);
+    }
+    CHECK_EQUAL(commands.count, 2);
+}
+
+static void testDrag() {
+    VoodooI2CGoodixGestureMachine machine;
+    step(machine, dragSequence[0]);
+
+    // The first move presses where the finger went down, then drags to where it is
+    Commands commands = step(machine, dragSequence[1]);
+    CHECK_EQUAL(machine.getState(), kGoodixGestureDragging);
+    CHECK_EQUAL(commands.count, 4);
+    CHECK_EQUAL(commands.outputs[0].command, kGoodixGestureCancelClick);
+    CHECK_EQUAL(commands.outputs[1].command, kGoodixGestureCancelHold);
+    CHECK(isDispatch(commands.outputs[2], kGoodixGestureButtonLeft, 100, 100));
+    CHECK(isDispatch(commands.outputs[3], kGoodixGestureButtonLeft, 110, 105));
+
+    for (int i = 2; i < 5; i++) {
+        commands = step(machine, dragSequence[i]);
+        CHECK_EQUAL(machine.getState(), kGoodixGestureDragging);
+        CHECK(isDispatch(commands.outputs[0], kGoodixGestureButtonLeft, dragSequence[i].x, dragSequence[i].y));
+    }
+
+    commands = step(machine, dragSequence[5]);
+    CHECK_EQUAL(machine.getState(), kGoodixGestureIdle);
+    CHECK_EQUAL(commands.outputs[0].command, kGoodixGestureLiftHover);
+}
+
+static void testHold() {
+    VoodooI2CGoodixGestureMachine machine;
+    step(machine, holdSequence[0]);
+
+    Commands commands = step(machine, holdSequence[1]);
+    CHECK_EQUAL(machine.getState(), kGoodixGesturePressed);
+
+    // Held still for RIGHT_CLICK_DELAY
+    commands = step(machine, holdSequence[2]);
+    CHECK_EQUAL(machine.getLastEvent(), kGoodixGestureHold);
+    CHECK_EQUAL(machine.getState(), kGoodixGestureRightClicked);
+    CHECK_EQUAL(commands.count, 4);
+    CHECK_EQUAL(commands.outputs[0].command, kGoodixGestureCancelClick);
+    CHECK_EQUAL(commands.outputs[1].command, kGoodixGestureCancelHold);
+    CHECK(isDispatch(commands.outputs[2], kGoodixGestureButtonRight, 800, 600));
+    CHECK(isDispatch(commands.outputs[3], kGoodixGestureButtonNone, 800, 600));
+
+    // Only one right click however long it's held
+    commands = step(machine, holdSequence[3]);
+    CHECK_EQUAL(commands.count, 1);
+    CHECK(isDispatch(commands.outputs[0], kGoodixGestureButtonNone, 800, 600));
+
+    commands = step(machine, holdSequence[4]);
+    CHECK_EQUAL(machine.getState(), kGoodixGestureIdle);
+    CHECK_EQUAL(commands.count, 1);
+}
+
+static void testHoldTimer() {
+    VoodooI2CGoodixGestureMachine machine;
+    step(machine, holdTimerSequence[0]);
+    step(machine, holdTimerSequence[1]);
+
+    // Right clicks where the finger went down, without a frame at RIGHT_CLICK_DELAY
+    Commands commands = step(machine, holdTimerSequence[2]);
+    CHECK_EQUAL(machine.getLastEvent(), kGoodixGestureHold);
+    CHECK_EQUAL(machine.getState(), kGoodixGestureRightClicked);
+    CHECK(isDispatch(commands.outputs[2], kGoodixGestureButtonRight, 800, 600));
+
+    commands = step(machine, holdTimerSequence[3]);
+    CHECK_EQUAL(machine.getState(), kGoodixGestureIdle);
+    CHECK_EQUAL(commands.count, 1);
+    CHECK_EQUAL(commands.outputs[0].command, kGoodixGestureLiftHover);
+}
+
+static void testRightClickDrag() {
+    VoodooI2CGoodixGestureMachine machine;
+    for (int i = 0; i < 3; i++) {
+        step(machine, rightClickDragSequence[i]);
+    }
+    CHECK_EQUAL(machine.getState(), kGoodixGestureRightClickMoved);
+
+    step(machine, rightClickDragSequence[3]);
+
+    // Lifting picks the menu item under the finger
+    Commands commands = step(machine, rightClickDragSequence[4]);
+    CHECK_EQUAL(machine.getState(), kGoodixGestureIdle);
+    CHECK_EQUAL(commands.count, 3);
+    CHECK(isDispatch(commands.outputs[0], kGoodixGestureButtonLeft, 950, 720));
+    CHECK(isDispatch(commands.outputs[1], kGoodixGestureButtonNone, 950, 720));
+    CHECK_EQUAL(commands.outputs[2].command, kGoodixGestureLiftHover);
+}
+
+// Drive a fresh machine into a state through the public interface
+static void enterState(VoodooI2CGoodixGestureMachine& machine, VoodooI2CGoodixGestureState state) {
+    machine.reset();
+    switch (state) {
+        case kGoodixGestureIdle:
+        case kGoodixGestureStateCount:
+            break;
+        case kGoodixGesturePressed:
+            machine.frame(100, 100, 0);
+            break;
+        case kGoodixGestureDragging:
+            machine.frame(100, 100, 0);
+            machine.frame(120, 100, 10000000);
+            break;
+        case kGoodixGestureRightClicked:
+            machine.frame(100, 100, 0);
+            machine.frame(100, 100, RIGHT_CLICK_DELAY * 1000000ULL);
+            break;
+        case kGoodixGestureRightClickMoved:
+            machine.frame(100, 100, 0);
+            machine.frame(100, 100, RIGHT_CLICK_DELAY * 1000000ULL);
+            machine.frame(300, 300, (RIGHT_CLICK_DELAY + 10) * 1000000ULL);
+            break;
+    }
+}
+
+static void testEveryTransitionFitsTheOutputs() {
+    VoodooI2CGoodixGestureMachine machine;
+    for (int state = 0; state < kGoodixGestureStateCount; state++) {
+        for (int event = 0; event < kGoodixGestureEventCount; event++) {
+            enterState(machine, (VoodooI2CGoodixGestureState)state);
+            CHECK_EQUAL(machine.getState(), state);
+
+            int count = machine.handle((VoodooI2CGoodixGestureEvent)event, 100, 100, 20000000);
+            CHECK(count >= 0 && count <= GOODIX_GESTURE_MAX_OUTPUTS);
+            CHECK_EQUAL(machine.getLastEvent(), event);
+        }
+    }
+}
+
+int main() {
+    testTap();
+    testDoubleClick();
+    testDrag();
+    testHold();
+    testHoldTimer();
+    testRightClickDrag();
+    testEveryTransitionFitsTheOutputs();
+    return TEST_RESULT();
+}
@@ -0,0 +1,292 @@
+//
+//  GestureSchedulerTests.cpp
+//  VoodooI2CGoodix
+//
+//  Created by agent on 10/17/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include "VoodooI2CGoodixGestureScheduler.hpp"
+#include "TestHelpers.hpp"
+
+#define MS  1000000ULL
+
+struct Command {
+    VoodooI2CGoodixGestureCommand command;
+    int button;
+    int x;
+    int y;
+    UInt64 at;
+};
+
+// Runs the scheduler on a virtual clock the way the event driver does, and logs every command with when it ran
+struct Harness {
+    VoodooI2CGoodixVirtualClock clock;
+    VoodooI2CGoodixGestureScheduler scheduler;
+    Command commands[64];
+    int count = 0;
+
+    Harness() {
+        scheduler.setClock(&clock);
+        clock.setAction(&Harness::timerFired, this);
+    }
+
+    static void timerFired(void* target, VoodooI2CGoodixTimerID timer) {
+        Harness* harness = (Harness*)target;
+        harness->log(harness->scheduler.timerFired(timer));
+    }
+
+    void log(int outputs) {
+        for (int i = 0; i < outputs; i++) {
+            const VoodooI2CGoodixGestureOutput& output = scheduler.getOutputs()[i];
+            commands[count++] = {output.command, output.button, output.x, output.y, scheduler.getEventNanoseconds()};
+        }
+    }
+
+    // A frame signalled at a time, which fires the timers due before it like a replayed frame
+    void frame(UInt64 at, int x, int y) {
+        clock.advanceTo(at);
+        scheduler.setEventTime(at);
+        log(scheduler.frame(x, y));
+    }
+
+    void lift(UInt64 at) {
+        clock.advanceTo(at);
+        scheduler.setEventTime(at);
+        log(scheduler.liftNow());
+    }
+
+    void multitouch(UInt64 at) {
+        clock.advanceTo(at);
+        scheduler.setEventTime(at);
+        scheduler.multitouch();
+    }
+
+    // The index of the first command with a button press after another, or -1
+    int find(VoodooI2CGoodixGestureCommand command, int button, int after = -1) const {
+        for (int i = after + 1; i < count; i++) {
+            if (commands[i].command == command && (command != kGoodixGestureDispatch || commands[i].button == button)) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    int countButton(int button) const {
+        int presses = 0;
+        for (int i = 0; i < count; i++) {
+            presses += commands[i].command == kGoodixGestureDispatch && commands[i].button == button;
+        }
+        return presses;
+    }
+};
+
+static void testTap() {
+    Harness harness;
+    harness.frame(0, 100, 200);
+    harness.frame(10 * MS, 100, 200);
+    harness.frame(20 * MS, 100, 200);
+    harness.lift(30 * MS);
+    CHECK_EQUAL(harness.countButton(kGoodixGestureButtonLeft), 0);
+
+    int lifted = harness.find(kGoodixGestureLifted, 0);
+    CHECK(lifted >= 0);
+    CHECK_EQUAL(harness.commands[lifted].at, 30 * MS);
+    CHECK(!harness.scheduler.isTouching());
+    CHECK(!harness.clock.isArmed(kGoodixTimerLift));
+
+    // The click timer armed by the last still frame clicks where the finger was
+    harness.clock.advanceTo(1000 * MS);
+    int left = harness.find(kGoodixGestureDispatch, kGoodixGestureButtonLeft);
+    CHECK(left > lifted);
+    CHECK_EQUAL(harness.commands[left].at, 120 * MS);
+    CHECK_EQUAL(harness.commands[left].x, 100);
+    CHECK_EQUAL(harness.commands[left].y, 200);
+    CHECK_EQUAL(harness.countButton(kGoodixGestureButtonLeft), 1);
+    CHECK_EQUAL(harness.commands[harness.count - 1].button, kGoodixGestureButtonNone);
+}
+
+static void testDoubleTap() {
+    Harness harness;
+    harness.frame(0, 100, 200);
+    harness.frame(10 * MS, 100, 200);
+    harness.lift(20 * MS);
+
+    // The second tap is close to the first, and its click comes within DOUBLE_CLICK_TIME of the first one's
+    harness.frame(200 * MS, 110, 190);
+    harness.frame(210 * MS, 110, 190);
+    harness.lift(220 * MS);
+    harness.clock.advanceTo(1000 * MS);
+
+    int first = harness.find(kGoodixGestureDispatch, kGoodixGestureButtonLeft);
+    CHECK_EQUAL(harness.commands[first].at, 110 * MS);
+
+    // Two more clicks at the first one's position
+    int second = harness.find(kGoodixGestureDispatch, kGoodixGestureButtonLeft, first);
+    int third = harness.find(kGoodixGestureDispatch, kGoodixGestureButtonLeft, second);
+    CHECK(second >= 0 && third >= 0);
+    CHECK_EQUAL(harness.commands[second].at, 310 * MS);
+    CHECK_EQUAL(harness.commands[third].at, 310 * MS);
+    CHECK_EQUAL(harness.commands[third].x, 100);
+    CHECK_EQUAL(harness.commands[third].y, 200);
+    CHECK_EQUAL(harness.countButton(kGoodixGestureButtonLeft), 3);
+}
+
+// A clock whose timers never fire on their own, like a work loop that's running late
+class StalledClock : public VoodooI2CGoodixClock {
+ public:
+    UInt64 now = 0;
+
+    UInt64 getNanoseconds() override {
+        return now;
+    }
+
+ protected:
+    void setWakeup(UInt64) override {}
+};
+
+static void testLongPress() {
+    Harness harness;
+    for (UInt64 at = 0; at <= 600 * MS; at += 30 * MS) {
+        harness.frame(at, 100, 200);
+    }
+
+    // The hold timer right clicks at RIGHT_CLICK_DELAY, between the frames at 480 and 510
+    int right = harness.find(kGoodixGestureDispatch, kGoodixGestureButtonRight);
+    CHECK(right >= 0);
+    CHECK_EQUAL(harness.commands[right].at, 500 * MS);
+    CHECK_EQUAL(harness.countButton(kGoodixGestureButtonRight), 1);
+
+    // The right click ended the click, so nothing is left-clicked after the finger lifts
+    harness.lift(620 * MS);
+    harness.clock.advanceTo(1000 * MS);
+    CHECK_EQUAL(harness.countButton(kGoodixGestureButtonLeft), 0);
+    CHECK_EQUAL(harness.scheduler.getGestures().getState(), kGoodixGestureIdle);
+}
+
+static void testHoldBeforeLostLift() {
+    // The last frame at 460 keeps the fingers down until 510, after the hold deadline
+    Harness harness;
+    for (UInt64 at = 0; at <= 460 * MS; at += 20 * MS) {
+        harness.frame(at, 100, 200);
+    }
+    harness.clock.advanceTo(1000 * MS);
+
+    int right = harness.find(kGoodixGestureDispatch, kGoodixGestureButtonRight);
+    int lifted = harness.find(kGoodixGestureLifted, 0);
+    CHECK(right >= 0 && lifted > right);
+    CHECK_EQUAL(harness.commands[right].at, 500 * MS);
+    CHECK_EQUAL(harness.commands[lifted].at, 510 * MS);
+    CHECK_EQUAL(harness.countButton(kGoodixGestureButtonLeft), 0);
+}
+
+static void testLostLiftBeforeHold() {
+    // The last frame at 440 lifts the fingers at 490, before the hold deadline, so it's a tap
+    Harness harness;
+    for (UInt64 at = 0; at <= 440 * MS; at += 20 * MS) {
+        harness.frame(at, 100, 200);
+    }
+    harness.clock.advanceTo(1000 * MS);
+
+    CHECK_EQUAL(harness.countButton(kGoodixGestureButtonRight), 0);
+    CHECK(!harness.clock.isArmed(kGoodixTimerHold));
+    int lifted = harness.find(kGoodixGestureLifted, 0);
+    CHECK(lifted >= 0);
+    CHECK_EQUAL(harness.commands[lifted].at, 490 * MS);
+}
+
+static void testLateHoldTimer() {
+    StalledClock clock;
+    VoodooI2CGoodixGestureScheduler scheduler;
+    scheduler.setClock(&clock);
+    scheduler.frame(100, 200);
+    CHECK(clock.isArmed(kGoodixTimerHold));
+
+    // A frame after the hold deadline moves away, but the finger was held long enough to right click first
+    clock.now = 520 * MS;
+    scheduler.setEventTime(520 * MS);
+    int count = scheduler.frame(300, 400);
+    CHECK(!clock.isArmed(kGoodixTimerHold));
+    CHECK(count >= 1);
+    CHECK_EQUAL(scheduler.getOutputs()[0].button, kGoodixGestureButtonRight);
+    CHECK_EQUAL(scheduler.getOutputs()[0].x, 100);
+    CHECK_EQUAL(scheduler.getGestures().getState(), kGoodixGestureRightClickMoved);
+
+    // And the same for a lift reported after the deadline
+    StalledClock other;
+    scheduler.setClock(&other);
+    scheduler.frame(100, 200);
+    other.now = 505 * MS;
+    scheduler.setEventTime(505 * MS);
+    count = scheduler.liftNow();
+    CHECK(count >= 2);
+    CHECK_EQUAL(scheduler.getOutputs()[0].button, kGoodixGestureButtonRight);
+    CHECK_EQUAL(scheduler.getOutputs()[count - 1].command, kGoodixGestureLifted);
+}
+
+static void testLostLift() {
+    Harness harness;
+    harness.frame(0, 100, 200);
+    harness.frame(10 * MS, 100, 200);
+    harness.frame(20 * MS, 100, 200);
+    CHECK(harness.scheduler.isTouching());
+
+    // The watchdog armed by the first frame fires at 50ms and waits for the last frame to go stale
+    harness.clock.advanceTo(60 * MS);
+    CHECK_EQUAL(harness.find(kGoodixGestureLifted, 0), -1);
+    CHECK(harness.clock.isArmed(kGoodixTimerLift));
+
+    harness.clock.advanceTo(1000 * MS);
+    int lifted = harness.find(kGoodixGestureLifted, 0);
+    CHECK(lifted >= 0);
+    CHECK_EQUAL(harness.commands[lifted].at, 70 * MS);
+    CHECK(harness.find(kGoodixGestureLiftHover, 0) < lifted);
+    CHECK(!harness.scheduler.isTouching());
+
+    // The lost lift still ends in a click
+    int left = harness.find(kGoodixGestureDispatch, kGoodixGestureButtonLeft);
+    CHECK(left > lifted);
+    CHECK_EQUAL(harness.commands[left].at, 120 * MS);
+}
+
+static void testMultitouchCancelsClick() {
+    Harness harness;
+    harness.frame(0, 100, 200);
+    harness.frame(10 * MS, 100, 200);
+    harness.multitouch(20 * MS);
+    CHECK(!harness.clock.isArmed(kGoodixTimerClick));
+
+    // The watchdog still lifts the fingers once the multitouch frames stop
+    harness.clock.advanceTo(1000 * MS);
+    int lifted = harness.find(kGoodixGestureLifted, 0);
+    CHECK(lifted >= 0);
+    CHECK_EQUAL(harness.commands[lifted].at, 70 * MS);
+    CHECK_EQUAL(harness.countButton(kGoodixGestureButtonLeft), 0);
+}
+
+static void testSetClockForgetsGesture() {
+    Harness harness;
+    harness.frame(100 * MS, 100, 200);
+    harness.frame(110 * MS, 100, 200);
+
+    VoodooI2CGoodixVirtualClock other(5 * MS);
+    harness.scheduler.setClock(&other);
+    CHECK(!harness.clock.isArmed(kGoodixTimerLift));
+    CHECK(!harness.clock.isArmed(kGoodixTimerClick));
+    CHECK(!harness.scheduler.isTouching());
+    CHECK_EQUAL(harness.scheduler.getEventNanoseconds(), 0);
+    CHECK_EQUAL(harness.scheduler.getGestures().getState(), kGoodixGestureIdle);
+}
+
+int main() {
+    testTap();
+    testDoubleTap();
+    testLongPress();
+    testHoldBeforeLostLift();
+    testLostLiftBeforeHold();
+    testLateHoldTimer();
+    testLostLift();
+    testMultitouchCancelsClick();
+    testSetClockForgetsGesture();
+    return TEST_RESULT();
+}
@@ -0,0 +1,94 @@
+//
+//  GestureSequences.hpp
+//  VoodooI2CGoodix
+//
+//  Created by agent on 10/17/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef GestureSequences_hpp
+#define GestureSequences_hpp
+
+#include "VoodooI2CGoodixGestureMachine.hpp"
+
+enum GestureInput {
+    kInputFrame,
+    kInputLift,
+    kInputClickTimeout,
+    kInputHoldTimeout
+};
+
+struct GestureStep {
+    GestureInput input;
+    int x;
+    int y;
+    uint64_t ms;
+};
+
+/* Single finger sequences as the event driver feeds them to the machine, 10 ms apart like the panel's reports */
+
+static const GestureStep tapSequence[] = {
+    {kInputFrame, 500, 300, 0},
+    {kInputFrame, 500, 300, 10},
+    {kInputFrame, 500, 300, 20},
+    {kInputLift, 0, 0, 30},
+    {kInputClickTimeout, 0, 0, 120}
+};
+
+static const GestureStep dragSequence[] = {
+    {kInputFrame, 100, 100, 0},
+    {kInputFrame, 110, 105, 10},
+    {kInputFrame, 180, 140, 20},
+    {kInputFrame, 260, 180, 30},
+    {kInputFrame, 260, 180, 40},
+    {kInputLift, 0, 0, 50}
+};
+
+static const GestureStep holdSequence[] = {
+    {kInputFrame, 800, 600, 0},
+    {kInputFrame, 800, 600, 250},
+    {kInputFrame, 800, 600, 500},
+    {kInputFrame, 800, 600, 510},
+    {kInputLift, 0, 0, 520}
+};
+
+// The hold timer right clicks without another frame
+static const GestureStep holdTimerSequence[] = {
+    {kInputFrame, 800, 600, 0},
+    {kInputFrame, 800, 600, 10},
+    {kInputHoldTimeout, 0, 0, 500},
+    {kInputLift, 0, 0, 520}
+};
+
+static const GestureStep rightClickDragSequence[] = {
+    {kInputFrame, 800, 600, 0},
+    {kInputFrame, 800, 600, 500},
+    {kInputFrame, 900, 700, 510},
+    {kInputFrame, 950, 720, 520},
+    {kInputLift, 0, 0, 530}
+};
+
+#define SEQUENCE_LENGTH(sequence) (int)(sizeof(sequence) / sizeof(sequence[0]))
+
+/* Feed one step to the machine
+ * @start Added to the step's time, in milliseconds
+ *
+ * @return the number of commands it produced
+ */
+
+static inline int runStep(VoodooI2CGoodixGestureMachine& machine, const GestureStep& step, uint64_t start = 0) {
+    uint64_t nanoseconds = (start + step.ms) * 1000000ULL;
+    switch (step.input) {
+        case kInputFrame:
+            return machine.frame(step.x, step.y, nanoseconds);
+        case kInputLift:
+            return machine.lift(nanoseconds);
+        case kInputClickTimeout:
+            return machine.clickTimeout(nanoseconds);
+        case kInputHoldTimeout:
+            return machine.hold(nanoseconds);
+    }
+    return 0;
+}
+
+#endif /* GestureSequences_hpp */
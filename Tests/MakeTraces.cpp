@@ -0,0 +1,114 @@
+//
+//  MakeTraces.cpp
+//  VoodooI2CGoodix
+//
+//  Created by agent on 10/17/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+// Writes the traces in traces/ that TraceTests replays
+//
+//   MakeTraces Tests/traces
+//
+// They're in the format the driver's TraceRecord property produces, with reports 10 ms apart
+// like the panel's. Traces recorded from a panel with TraceRecord can be checked in next to them.
+
+#include <stdio.h>
+#include <string.h>
+#include "VoodooI2CGoodixTrace.hpp"
+
+#define MS      1000000ULL
+
+// An uptime well after boot, so nothing depends on traces starting at 0
+#define START   (7300 * MS)
+
+struct Contact {
+    int id;
+    int x;
+    int y;
+};
+
+static void appendReport(VoodooI2CGoodixTraceWriter& writer, UInt64 ms, const Contact* contacts, int count) {
+    UInt8 report[GOODIX_TRACE_REPORT_MAX] = {};
+    report[0] = GOODIX_BUFFER_STATUS_READY | count;
+    for (int i = 0; i < count; i++) {
+        UInt8* contact = &report[1 + i * GOODIX_CONTACT_SIZE];
+        contact[0] = contacts[i].id;
+        contact[1] = contacts[i].x & 0xff;
+        contact[2] = contacts[i].x >> 8;
+        contact[3] = contacts[i].y & 0xff;
+        contact[4] = contacts[i].y >> 8;
+        contact[5] = 24;
+    }
+    writer.append(START + ms * MS, report, 1 + count * GOODIX_CONTACT_SIZE + 1);
+}
+
+static void appendFinger(VoodooI2CGoodixTraceWriter& writer, UInt64 ms, int x, int y) {
+    Contact contact = {0, x, y};
+    appendReport(writer, ms, &contact, 1);
+}
+
+static void appendLift(VoodooI2CGoodixTraceWriter& writer, UInt64 ms) {
+    appendReport(writer, ms, NULL, 0);
+}
+
+static bool save(VoodooI2CGoodixTraceWriter& writer, const char* directory, const char* name) {
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/%s.goodixtrace", directory, name);
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        perror(path);
+        return false;
+    }
+    bool written = fwrite(writer.getBytes(), 1, writer.getLength(), file) == writer.getLength();
+    fclose(file);
+    printf("%s: %u reports\n", path, writer.getRecords());
+    return written;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <directory>\n", argv[0]);
+        return 2;
+    }
+    const char* directory = argv[1];
+    VoodooI2CGoodixTraceWriter writer;
+    bool saved = true;
+
+    // A finger down for 30 ms
+    writer.start();
+    for (UInt64 ms = 0; ms <= 30; ms += 10) {
+        appendFinger(writer, ms, 500, 300);
+    }
+    appendLift(writer, 40);
+    saved &= save(writer, directory, "tap");
+
+    // A finger down at 100,100 that drags to 400,250 in 150 ms
+    writer.start();
+    appendFinger(writer, 0, 100, 100);
+    for (int i = 1; i <= 15; i++) {
+        appendFinger(writer, i * 10, 100 + i * 20, 100 + i * 10);
+    }
+    appendLift(writer, 160);
+    saved &= save(writer, directory, "drag");
+
+    // One finger down, then a second one, scrolling down together for 200 ms
+    writer.start();
+    appendFinger(writer, 0, 600, 400);
+    for (int i = 1; i <= 20; i++) {
+        Contact contacts[2] = {{0, 600, 400 + i * 8}, {1, 700, 410 + i * 8}};
+        appendReport(writer, i * 10, contacts, 2);
+    }
+    appendLift(writer, 210);
+    saved &= save(writer, directory, "two-finger");
+
+    // A finger held still for 700 ms
+    writer.start();
+    for (UInt64 ms = 0; ms <= 700; ms += 10) {
+        appendFinger(writer, ms, 800, 600);
+    }
+    appendLift(writer, 710);
+    saved &= save(writer, directory, "long-press");
+
+    return saved ? 0 : 1;
+}
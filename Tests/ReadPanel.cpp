@@ -0,0 +1,75 @@
+//
+//  ReadPanel.cpp
+//  VoodooI2CGoodix
+//
+//  Created by agent on 10/17/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "VoodooI2CGoodixI2CDevTransport.hpp"
+#include "VoodooI2CGoodixReport.hpp"
+
+/* Reads a real panel through i2c-dev with the kext's report parser and prints every frame
+ *
+ *   ReadPanel /dev/i2c-1 0x5d
+ */
+
+static UInt64 uptimeNanoseconds() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (UInt64)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        fprintf(stderr, "usage: %s <i2c-dev> <address>\n", argv[0]);
+        return 2;
+    }
+
+    VoodooI2CGoodixI2CDevTransport transport;
+    if (!transport.open(argv[1], (UInt16)strtoul(argv[2], NULL, 0))) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    UInt8 version[6];
+    if (transport.readVersion(version, sizeof(version)) != kIOReturnSuccess) {
+        fprintf(stderr, "Could not read the version, is the panel bound to another driver?\n");
+        return 1;
+    }
+    printf("ID %.4s, version 0x%04x\n", (const char*)version, version[4] | version[5] << 8);
+
+    UInt8 data[GOODIX_REPORT_MAX_LENGTH];
+    TouchFrame frame = {};
+    int predicted_touch_num = 1;
+    while (true) {
+        int touch_num = goodix_read_report(&transport, data, predicted_touch_num, GOODIX_MAX_CONTACTS);
+        if (touch_num == GOODIX_REPORT_NOT_READY) {
+            usleep(GOODIX_POLL_INTERVAL);
+            continue;
+        }
+        if (touch_num < 0) {
+            fprintf(stderr, "Read failed: %d\n", touch_num);
+            transport.endCmd();
+            continue;
+        }
+
+        goodix_decode_report(data, touch_num, VoodooI2CGoodixTransform(), &frame);
+        transport.endCmd();
+        predicted_touch_num = touch_num > 0 ? touch_num : 1;
+
+        printf("%llu:", (unsigned long long)(uptimeNanoseconds() / 1000));
+        for (int i = 0; i < frame.numTouches; i++) {
+            const Touch& touch = frame.touches[i];
+            printf(" %s%d (%d, %d) w%d", touch.type ? "pen" : "finger", touch.id, touch.x, touch.y, touch.width);
+        }
+        if (frame.stylusButton1 || frame.stylusButton2) {
+            printf(" buttons %d%d", frame.stylusButton1, frame.stylusButton2);
+        }
+        printf("\n");
+    }
+}
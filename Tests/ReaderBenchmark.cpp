@@ -0,0 +1,97 @@
+//
+//  ReaderBenchmark.cpp
+//  VoodooI2CGoodix
+//
+//  Created by agent on 10/17/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdio.h>
+#include <thread>
+
+#include "VoodooI2CGoodixLatencyHistogram.hpp"
+
+#define FRAMES  20000
+
+/* Compares the two ways of getting from an interrupt to the code that reads the report
+ *
+ * The old driver started a thread for every interrupt with kernel_thread_start, the reader
+ * thread now sleeps on a flag under reader_lock and is woken for each one. Each frame here is
+ * handled before the next is signalled, so the per-frame time is the whole cost of one
+ * interrupt, and the latency is from the signal to the handler running.
+ */
+
+typedef VoodooI2CGoodixLatencyHistogram<1000, 1> Histogram;
+
+static uint64_t nowNanoseconds() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void print(const char* name, const Histogram& latency, uint64_t elapsed) {
+    printf("%-17s %6.2f us per frame, wakeup latency p50 %4llu us p99 %4llu us max %llu us\n",
+           name, (double)elapsed / FRAMES / 1000,
+           (unsigned long long)latency.percentile(50), (unsigned long long)latency.percentile(99), (unsigned long long)latency.max());
+}
+
+static void threadPerFrame() {
+    Histogram latency;
+
+    uint64_t begin = nowNanoseconds();
+    for (int i = 0; i < FRAMES; i++) {
+        uint64_t signalled = nowNanoseconds();
+        std::thread handler([&latency, signalled] {
+            latency.record((nowNanoseconds() - signalled) / 1000);
+        });
+        handler.join();
+    }
+    print("thread per frame", latency, nowNanoseconds() - begin);
+}
+
+static void persistentReader() {
+    Histogram latency;
+    std::mutex lock;
+    std::condition_variable wakeup;
+    bool pending = false;
+    bool exiting = false;
+    uint64_t signalled = 0;
+
+    std::thread reader([&] {
+        std::unique_lock<std::mutex> guard(lock);
+        while (true) {
+            wakeup.wait(guard, [&] { return pending || exiting; });
+            if (!pending) {
+                return;
+            }
+            latency.record((nowNanoseconds() - signalled) / 1000);
+            pending = false;
+            wakeup.notify_all();
+        }
+    });
+
+    uint64_t begin = nowNanoseconds();
+    for (int i = 0; i < FRAMES; i++) {
+        std::unique_lock<std::mutex> guard(lock);
+        signalled = nowNanoseconds();
+        pending = true;
+        wakeup.notify_all();
+        wakeup.wait(guard, [&] { return !pending; });
+    }
+    uint64_t elapsed = nowNanoseconds() - begin;
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        exiting = true;
+    }
+    wakeup.notify_all();
+    reader.join();
+    print("persistent reader", latency, elapsed);
+}
+
+int main() {
+    threadPerFrame();
+    persistentReader();
+    return 0;
+}
@@ -0,0 +1,236 @@
+//
+//  ReportTests.cpp
+//  VoodooI2CGoodix
+//
+//  Created by agent on 10/17/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include "VoodooI2CGoodixClock.hpp"
+#include "VoodooI2CGoodixReport.hpp"
+#include "VoodooI2CGoodixSimulator.hpp"
+#include "TestHelpers.hpp"
+
+#define MS  1000000ULL
+
+static UInt64 virtualTime(void* ref) {
+    return ((VoodooI2CGoodixVirtualClock*)ref)->getNanoseconds();
+}
+
+// A simulated panel on virtual time that counts the report reads, and can fail one of them
+class TestPanel : public VoodooI2CGoodixSimulator {
+ public:
+    VoodooI2CGoodixVirtualClock clock;
+    int reads = 0;
+    int failingRead = 0;
+
+    TestPanel() : VoodooI2CGoodixSimulator(&virtualTime, &clock) {
+        // The simulator read the clock before it was constructed
+        resetScript();
+        configure(911, 0x1060, GOODIX_GT9X_REG_CONFIG_DATA, GOODIX_CONFIG_911_LENGTH, 1280, 800, GOODIX_MAX_CONTACTS, 5);
+    }
+
+    IOReturn readReport(UInt16 offset, UInt8* values, size_t len) override {
+        if (++reads == failingRead) {
+            return kIOReturnIOError;
+        }
+        return VoodooI2CGoodixSimulator::readReport(offset, values, len);
+    }
+};
+
+static const VoodooI2CGoodixSimulatedContact threeFingers[] = {
+    {0, 100, 200, 30, false},
+    {1, 300, 400, 31, false},
+    {2, 500, 600, 32, false}
+};
+
+static void testNotReadyBeforeReadyDelay() {
+    TestPanel panel;
+    UInt8 data[GOODIX_REPORT_MAX_LENGTH];
+    panel.scriptFrame(0, threeFingers, 1);
+
+    panel.clock.advanceTo(GOODIX_SIMULATOR_READY_DELAY - 1);
+    CHECK(panel.takeInterrupt());
+    CHECK_EQUAL(goodix_read_report(&panel, data, 1, GOODIX_MAX_CONTACTS), GOODIX_REPORT_NOT_READY);
+
+    panel.clock.advanceTo(GOODIX_SIMULATOR_READY_DELAY);
+    CHECK_EQUAL(goodix_read_report(&panel, data, 1, GOODIX_MAX_CONTACTS), 1);
+}
+
+static void testSpeculativeRead() {
+    TestPanel panel;
+    UInt8 data[GOODIX_REPORT_MAX_LENGTH];
+    TouchFrame frame = {};
+    panel.scriptFrame(0, threeFingers, 3);
+    panel.scriptFrame(20 * MS, threeFingers, 2);
+
+    // A miss reads the rest of the contacts in a second transfer
+    panel.clock.advanceTo(10 * MS);
+    CHECK_EQUAL(goodix_read_report(&panel, data, 1, GOODIX_MAX_CONTACTS), 3);
+    CHECK_EQUAL(panel.reads, 2);
+    goodix_decode_report(data, 3, VoodooI2CGoodixTransform(), &frame);
+    CHECK_EQUAL(frame.numTouches, 3);
+    for (int i = 0; i < 3; i++) {
+        CHECK_EQUAL(frame.touches[i].id, threeFingers[i].id);
+        CHECK_EQUAL(frame.touches[i].x, threeFingers[i].x);
+        CHECK_EQUAL(frame.touches[i].y, threeFingers[i].y);
+        CHECK_EQUAL(frame.touches[i].width, threeFingers[i].width);
+        CHECK_EQUAL(frame.touches[i].type, GOODIX_TOOL_FINGER);
+    }
+    CHECK_EQUAL(panel.endCmd(), kIOReturnSuccess);
+
+    // A report with as many or fewer contacts than predicted takes one
+    panel.reads = 0;
+    panel.clock.advanceTo(30 * MS);
+    CHECK_EQUAL(goodix_read_report(&panel, data, 3, GOODIX_MAX_CONTACTS), 2);
+    CHECK_EQUAL(panel.reads, 1);
+}
+
+static void testStylusButtons() {
+    TestPanel panel;
+    UInt8 data[GOODIX_REPORT_MAX_LENGTH];
+    TouchFrame frame = {};
+    VoodooI2CGoodixSimulatedContact pen = {0, 10, 20, 0, true};
+    panel.scriptFrame(0, &pen, 1, 0x10);
+    panel.scriptFrame(20 * MS, &pen, 1, 0x40);
+    panel.scriptFrame(40 * MS, &pen, 1, 0);
+
+    panel.clock.advanceTo(10 * MS);
+    CHECK_EQUAL(goodix_read_report(&panel, data, 1, GOODIX_MAX_CONTACTS), 1);
+    goodix_decode_report(data, 1, VoodooI2CGoodixTransform(), &frame);
+    CHECK_EQUAL(frame.touches[0].type, GOODIX_TOOL_PEN);
+    CHECK(frame.stylusButton1);
+    CHECK(!frame.stylusButton2);
+    panel.endCmd();
+
+    panel.clock.advanceTo(30 * MS);
+    CHECK_EQUAL(goodix_read_report(&panel, data, 1, GOODIX_MAX_CONTACTS), 1);
+    goodix_decode_report(data, 1, VoodooI2CGoodixTransform(), &frame);
+    CHECK(frame.stylusButton1);
+    CHECK(frame.stylusButton2);
+    panel.endCmd();
+
+    panel.clock.advanceTo(50 * MS);
+    CHECK_EQUAL(goodix_read_report(&panel, data, 1, GOODIX_MAX_CONTACTS), 1);
+    goodix_decode_report(data, 1, VoodooI2CGoodixTransform(), &frame);
+    CHECK(!frame.stylusButton1);
+    CHECK(!frame.stylusButton2);
+}
+
+static void testLift() {
+    TestPanel panel;
+    UInt8 data[GOODIX_REPORT_MAX_LENGTH];
+    TouchFrame frame = {};
+    frame.numTouches = 2;
+    panel.scriptFrame(0, NULL, 0);
+
+    panel.clock.advanceTo(10 * MS);
+    CHECK_EQUAL(goodix_read_report(&panel, data, 1, GOODIX_MAX_CONTACTS), 0);
+    goodix_decode_report(data, 0, VoodooI2CGoodixTransform(), &frame);
+    CHECK_EQUAL(frame.numTouches, 0);
+}
+
+static void testTooManyContacts() {
+    TestPanel panel;
+    UInt8 data[GOODIX_REPORT_MAX_LENGTH];
+    panel.scriptFrame(0, threeFingers, 3);
+
+    panel.clock.advanceTo(10 * MS);
+    CHECK_EQUAL(goodix_read_report(&panel, data, 1, 2), GOODIX_REPORT_INVALID);
+}
+
+static void testBusError() {
+    TestPanel panel;
+    UInt8 data[GOODIX_REPORT_MAX_LENGTH];
+    panel.scriptFrame(0, threeFingers, 3);
+    panel.scriptError(10 * MS, 1);
+
+    panel.clock.advanceTo(10 * MS);
+    CHECK_EQUAL(goodix_read_report(&panel, data, 1, GOODIX_MAX_CONTACTS), GOODIX_REPORT_ERROR);
+
+    // The read of the contacts that weren't predicted can fail too
+    panel.failingRead = panel.reads + 2;
+    CHECK_EQUAL(goodix_read_report(&panel, data, 1, GOODIX_MAX_CONTACTS), GOODIX_REPORT_ERROR);
+    CHECK_EQUAL(goodix_read_report(&panel, data, 1, GOODIX_MAX_CONTACTS), 3);
+}
+
+static void testEndCmdClearsStatus() {
+    TestPanel panel;
+    UInt8 data[GOODIX_REPORT_MAX_LENGTH];
+    panel.scriptFrame(0, threeFingers, 1);
+
+    panel.clock.advanceTo(10 * MS);
+    CHECK_EQUAL(goodix_read_report(&panel, data, 1, GOODIX_MAX_CONTACTS), 1);
+    CHECK_EQUAL(goodix_read_report(&panel, data, 1, GOODIX_MAX_CONTACTS), 1);
+    CHECK_EQUAL(panel.endCmd(), kIOReturnSuccess);
+    CHECK_EQUAL(goodix_read_report(&panel, data, 1, GOODIX_MAX_CONTACTS), GOODIX_REPORT_NOT_READY);
+    CHECK_EQUAL(panel.getOverruns(), 0);
+}
+
+static void testFrameBeforeReadyIsOverrun() {
+    TestPanel panel;
+    UInt8 data[GOODIX_REPORT_MAX_LENGTH];
+    TouchFrame frame = {};
+    panel.setReadyDelay(10 * MS);
+    VoodooI2CGoodixSimulatedContact moved = {0, 150, 250, 30, false};
+    panel.scriptFrame(0, threeFingers, 1);
+    panel.scriptFrame(5 * MS, &moved, 1);
+
+    // The first frame was replaced before it became ready, only the second one is ever read
+    panel.clock.advanceTo(14 * MS);
+    CHECK_EQUAL(goodix_read_report(&panel, data, 1, GOODIX_MAX_CONTACTS), GOODIX_REPORT_NOT_READY);
+    CHECK_EQUAL(panel.getOverruns(), 1);
+
+    panel.clock.advanceTo(15 * MS);
+    CHECK_EQUAL(goodix_read_report(&panel, data, 1, GOODIX_MAX_CONTACTS), 1);
+    goodix_decode_report(data, 1, VoodooI2CGoodixTransform(), &frame);
+    CHECK_EQUAL(frame.touches[0].x, 150);
+    CHECK_EQUAL(panel.getOverruns(), 1);
+}
+
+static void testUntrackableIdsAreSkipped() {
+    TestPanel panel;
+    UInt8 data[GOODIX_REPORT_MAX_LENGTH];
+    TouchFrame frame = {};
+    VoodooI2CGoodixSimulatedContact contacts[] = {
+        {12, 1, 2, 3, false},
+        {4, 5, 6, 7, false}
+    };
+    panel.scriptFrame(0, contacts, 2);
+
+    panel.clock.advanceTo(10 * MS);
+    CHECK_EQUAL(goodix_read_report(&panel, data, 2, GOODIX_MAX_CONTACTS), 2);
+    goodix_decode_report(data, 2, VoodooI2CGoodixTransform(), &frame);
+    CHECK_EQUAL(frame.numTouches, 1);
+    CHECK_EQUAL(frame.touches[0].id, 4);
+    CHECK_EQUAL(frame.touches[0].x, 5);
+}
+
+static void testTransformIsApplied() {
+    TestPanel panel;
+    UInt8 data[GOODIX_REPORT_MAX_LENGTH];
+    TouchFrame frame = {};
+    panel.scriptFrame(0, threeFingers, 1);
+
+    panel.clock.advanceTo(10 * MS);
+    CHECK_EQUAL(goodix_read_report(&panel, data, 1, GOODIX_MAX_CONTACTS), 1);
+    VoodooI2CGoodixTransform transform = VoodooI2CGoodixTransform::swapAxes().then(VoodooI2CGoodixTransform::invert(true, false, 800, 1280));
+    goodix_decode_report(data, 1, transform, &frame);
+    CHECK_EQUAL(frame.touches[0].x, 800 - 200);
+    CHECK_EQUAL(frame.touches[0].y, 100);
+    CHECK_EQUAL(frame.touches[0].width, 30);
+}
+
+int main() {
+    testNotReadyBeforeReadyDelay();
+    testSpeculativeRead();
+    testStylusButtons();
+    testLift();
+    testTooManyContacts();
+    testBusError();
+    testEndCmdClearsStatus();
+    testFrameBeforeReadyIsOverrun();
+    testUntrackableIdsAreSkipped();
+    testTransformIsApplied();
+    return TEST_RESULT();
+}
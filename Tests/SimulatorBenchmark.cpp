@@ -0,0 +1,138 @@
+//
+//  SimulatorBenchmark.cpp
+//  VoodooI2CGoodix
+//
+//  Created by agent on 10/17/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include <chrono>
+#include <stdio.h>
+
+#include "VoodooI2CGoodixClock.hpp"
+#include "VoodooI2CGoodixContactTracker.hpp"
+#include "VoodooI2CGoodixLatencyHistogram.hpp"
+#include "VoodooI2CGoodixReport.hpp"
+#include "VoodooI2CGoodixSimulator.hpp"
+
+#define MS                  1000000ULL
+#define US                  1000ULL
+#define SIMULATED_TIME      (600 * 1000 * MS)
+#define INTERRUPT_STEP      (50 * US)
+#define FRAME_INTERVAL      (10 * MS)
+#define READY_DELAY         (6 * MS)
+#define DRAG_FRAMES         20
+
+/* Drives the report parser and contact tracker with a simulated panel on virtual time
+ *
+ * The reader polls the buffer status after each interrupt like goodix_ts_read_input_report does
+ * before it has learned the ready delay, so the simulated latency, the polls and the overruns are
+ * the same on every run. Only the host time per report depends on the machine.
+ */
+
+struct Scenario {
+    const char* name;
+    int fingers;
+    UInt64 pollInterval;
+    bool spurious; // a spurious interrupt after every lift, like the real panel
+    bool errors; // a failed transfer once per script, the report it loses becomes ready unread, so
+                 // the reader answers each interrupt with the previous frame until the next lift
+};
+
+static const Scenario scenarios[] = {
+    {"1 finger", 1, GOODIX_POLL_INTERVAL * US, false, false},
+    {"1 finger fine", 1, GOODIX_POLL_INTERVAL_FINE * US, false, false},
+    {"5 fingers", 5, GOODIX_POLL_INTERVAL * US, false, false},
+    {"5 fingers fine", 5, GOODIX_POLL_INTERVAL_FINE * US, false, false},
+    {"spurious", 1, GOODIX_POLL_INTERVAL * US, true, false},
+    {"bus errors", 1, GOODIX_POLL_INTERVAL * US, false, true}
+};
+
+static UInt64 virtualTime(void* ref) {
+    return ((VoodooI2CGoodixVirtualClock*)ref)->getNanoseconds();
+}
+
+static void scriptDrag(VoodooI2CGoodixSimulator& panel, const Scenario& scenario) {
+    VoodooI2CGoodixSimulatedContact contacts[GOODIX_MAX_CONTACTS];
+    UInt64 at = 0;
+    for (int frame = 0; frame < DRAG_FRAMES; frame++, at += FRAME_INTERVAL) {
+        for (int i = 0; i < scenario.fingers; i++) {
+            contacts[i] = {(UInt8)i, (UInt16)(100 + frame * 10 + i * 150), (UInt16)(200 + frame * 5), 30, false};
+        }
+        panel.scriptFrame(at, contacts, scenario.fingers);
+        if (scenario.errors && frame == DRAG_FRAMES / 2) {
+            panel.scriptError(at + 1, 1);
+        }
+    }
+    panel.scriptFrame(at, NULL, 0);
+    if (scenario.spurious) {
+        panel.scriptSpuriousInterrupt(at + FRAME_INTERVAL);
+    }
+    panel.setLoop(at + 3 * FRAME_INTERVAL);
+}
+
+static void run(const Scenario& scenario) {
+    VoodooI2CGoodixVirtualClock clock;
+    VoodooI2CGoodixSimulator panel(&virtualTime, &clock);
+    panel.configure(911, 0x1060, GOODIX_GT9X_REG_CONFIG_DATA, GOODIX_CONFIG_911_LENGTH, 1280, 800, GOODIX_MAX_CONTACTS, 5);
+    // Shorter than the frame interval, so each report is read before the next interrupt
+    panel.setReadyDelay(READY_DELAY);
+    scriptDrag(panel, scenario);
+
+    VoodooI2CGoodixContactTracker tracker;
+    VoodooI2CGoodixLatencyHistogram<GOODIX_READY_DELAY_BUCKETS, GOODIX_READY_DELAY_BUCKET_WIDTH> latency;
+    VoodooI2CGoodixTransform transform;
+    UInt8 data[GOODIX_REPORT_MAX_LENGTH];
+    TouchFrame frame = {};
+    int predicted_touch_num = 1;
+    UInt64 reports = 0, polls = 0, timeouts = 0, errors = 0, contacts = 0;
+
+    auto begin = std::chrono::steady_clock::now();
+    while (clock.getNanoseconds() < SIMULATED_TIME) {
+        clock.advance(INTERRUPT_STEP);
+        if (!panel.takeInterrupt()) {
+            continue;
+        }
+
+        UInt64 interrupt = clock.getNanoseconds();
+        int touch_num;
+        while (true) {
+            polls++;
+            touch_num = goodix_read_report(&panel, data, predicted_touch_num, GOODIX_MAX_CONTACTS);
+            if (touch_num != GOODIX_REPORT_NOT_READY || clock.getNanoseconds() - interrupt >= GOODIX_BUFFER_STATUS_TIMEOUT) {
+                break;
+            }
+            clock.advance(scenario.pollInterval);
+        }
+
+        if (touch_num == GOODIX_REPORT_NOT_READY) {
+            timeouts++;
+            continue;
+        }
+        if (touch_num >= 0) {
+            latency.record((clock.getNanoseconds() - interrupt) / US);
+            goodix_decode_report(data, touch_num, transform, &frame);
+            contacts += tracker.update(frame.touches, frame.numTouches);
+            predicted_touch_num = touch_num > 0 ? touch_num : 1;
+            reports++;
+        }
+        else {
+            errors++;
+        }
+        panel.endCmd();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double nanoseconds = std::chrono::duration<double, std::nano>(end - begin).count();
+    printf("%-15s %7llu reports, %5.2f polls per report, latency p50 %5llu us p99 %5llu us max %5llu us, %llu timeouts, %llu errors, %u overruns, %6.0f host ns per report (%llu contacts)\n",
+           scenario.name, (unsigned long long)reports, (double)polls / reports,
+           (unsigned long long)latency.percentile(50), (unsigned long long)latency.percentile(99), (unsigned long long)latency.max(),
+           (unsigned long long)timeouts, (unsigned long long)errors, panel.getOverruns(), nanoseconds / reports, (unsigned long long)contacts);
+}
+
+int main() {
+    for (const Scenario& scenario : scenarios) {
+        run(scenario);
+    }
+    return 0;
+}
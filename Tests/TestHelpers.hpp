@@ -0,0 +1,39 @@
+//
+//  TestHelpers.hpp
+//  VoodooI2CGoodix
+//
+//  Created by agent on 10/17/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef TestHelpers_hpp
+#define TestHelpers_hpp
+
+#include <stdio.h>
+
+/* Failed checks are counted, and the test's main returns TEST_RESULT() so ctest sees them */
+
+static int testFailures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            testFailures++; \
+        } \
+    } while (0)
+
+#define CHECK_EQUAL(actual, expected) \
+    do { \
+        long long actualValue = (long long)(actual); \
+        long long expectedValue = (long long)(expected); \
+        if (actualValue != expectedValue) { \
+            fprintf(stderr, "%s:%d: %s was %lld, expected %lld\n", __FILE__, __LINE__, #actual, actualValue, expectedValue); \
+            testFailures++; \
+        } \
+    } while (0)
+
+#define TEST_RESULT() \
+    (testFailures ? (fprintf(stderr, "%d checks failed\n", testFailures), 1) : 0)
+
+#endif /* TestHelpers_hpp */
@@ -0,0 +1,203 @@
+//
+//  TraceTests.cpp
+//  VoodooI2CGoodix
+//
+//  Created by agent on 10/17/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include <stdlib.h>
+#include "VoodooI2CGoodixGestureScheduler.hpp"
+#include "VoodooI2CGoodixReport.hpp"
+#include "VoodooI2CGoodixTrace.hpp"
+#include "TestHelpers.hpp"
+
+#define MS  1000000ULL
+
+// When the traces in traces/ start, see MakeTraces
+#define START   (7300 * MS)
+
+struct Command {
+    VoodooI2CGoodixGestureCommand command;
+    int button;
+    int x;
+    int y;
+    UInt64 at;
+};
+
+// Replays a trace the way the touch driver's TraceReplay does, and the event driver reports it
+struct Replay {
+    VoodooI2CGoodixVirtualClock clock;
+    VoodooI2CGoodixGestureScheduler scheduler;
+    bool isMultitouch = false;
+    int reports = 0;
+    int multitouchFrames = 0;
+    Command commands[256];
+    int count = 0;
+
+    static void timerFired(void* target, VoodooI2CGoodixTimerID timer) {
+        Replay* replay = (Replay*)target;
+        replay->log(replay->scheduler.timerFired(timer));
+    }
+
+    void log(int outputs) {
+        for (int i = 0; i < outputs; i++) {
+            const VoodooI2CGoodixGestureOutput& output = scheduler.getOutputs()[i];
+            commands[count++] = {output.command, output.button, output.x, output.y, scheduler.getEventNanoseconds() - START};
+            if (output.command == kGoodixGestureLifted) {
+                isMultitouch = false;
+            }
+        }
+    }
+
+    void report(const TouchFrame& frame) {
+        clock.advanceTo(frame.timestamp);
+        scheduler.setEventTime(frame.timestamp);
+        if (frame.numTouches == 0) {
+            log(scheduler.liftNow());
+        }
+        else if (frame.numTouches == 1) {
+            if (!isMultitouch) {
+                log(scheduler.frame(frame.touches[0].x, frame.touches[0].y));
+            }
+        }
+        else {
+            scheduler.multitouch();
+            isMultitouch = true;
+            multitouchFrames++;
+        }
+    }
+
+    // Replay a trace from traces/, then let the timers it left armed fire
+    bool run(const char* name) {
+        char path[1024];
+        snprintf(path, sizeof(path), "%s/%s.goodixtrace", TRACE_DIRECTORY, name);
+        FILE* file = fopen(path, "rb");
+        if (!file) {
+            perror(path);
+            return false;
+        }
+        static UInt8 bytes[GOODIX_TRACE_CAPACITY];
+        size_t length = fread(bytes, 1, sizeof(bytes), file);
+        fclose(file);
+
+        VoodooI2CGoodixTraceReader reader(bytes, length);
+        VoodooI2CGoodixTraceRecord record;
+        if (!reader.isValid() || !reader.next(record)) {
+            return false;
+        }
+
+        // beginReplay
+        clock.reset(record.timestamp);
+        scheduler.setClock(&clock);
+        clock.setAction(&Replay::timerFired, this);
+
+        do {
+            TouchFrame frame;
+            goodix_decode_report(record.report, record.report[0] & 0x0f, VoodooI2CGoodixTransform(), &frame);
+            frame.timestamp = record.timestamp;
+            frame.readTimestamp = 0;
+            report(frame);
+            reports++;
+        } while (reader.next(record));
+
+        // endReplay
+        clock.advance(1000 * MS);
+        return reader.isValid();
+    }
+
+    int find(VoodooI2CGoodixGestureCommand command, int button = kGoodixGestureButtonNone, int after = -1) const {
+        for (int i = after + 1; i < count; i++) {
+            if (commands[i].command == command && (command != kGoodixGestureDispatch || commands[i].button == button)) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    int countButton(int button) const {
+        int presses = 0;
+        for (int i = 0; i < count; i++) {
+            presses += commands[i].command == kGoodixGestureDispatch && commands[i].button == button;
+        }
+        return presses;
+    }
+};
+
+static void testTap() {
+    Replay replay;
+    CHECK(replay.run("tap"));
+    CHECK_EQUAL(replay.reports, 5);
+
+    // Lifted by the panel's report, then clicked by the click timer armed by the last still frame
+    int lifted = replay.find(kGoodixGestureLifted);
+    CHECK_EQUAL(replay.commands[lifted].at, 40 * MS);
+    int left = replay.find(kGoodixGestureDispatch, kGoodixGestureButtonLeft);
+    CHECK(left > lifted);
+    CHECK_EQUAL(replay.commands[left].at, 130 * MS);
+    CHECK_EQUAL(replay.commands[left].x, 500);
+    CHECK_EQUAL(replay.commands[left].y, 300);
+    CHECK_EQUAL(replay.countButton(kGoodixGestureButtonLeft), 1);
+    CHECK_EQUAL(replay.countButton(kGoodixGestureButtonRight), 0);
+}
+
+static void testDrag() {
+    Replay replay;
+    CHECK(replay.run("drag"));
+
+    // The first move presses where the finger went down, and every move after holds the button
+    int first = replay.find(kGoodixGestureDispatch, kGoodixGestureButtonLeft);
+    CHECK(first >= 0);
+    CHECK_EQUAL(replay.commands[first].x, 100);
+    CHECK_EQUAL(replay.commands[first].y, 100);
+    CHECK_EQUAL(replay.commands[first].at, 10 * MS);
+    CHECK_EQUAL(replay.countButton(kGoodixGestureButtonLeft), 16);
+
+    int hover = replay.find(kGoodixGestureLiftHover);
+    CHECK(hover >= 0);
+    CHECK_EQUAL(replay.commands[hover].at, 160 * MS);
+    CHECK_EQUAL(replay.commands[hover - 1].x, 400);
+    CHECK_EQUAL(replay.commands[hover - 1].y, 250);
+    CHECK_EQUAL(replay.countButton(kGoodixGestureButtonRight), 0);
+    CHECK_EQUAL(replay.scheduler.getGestures().getState(), kGoodixGestureIdle);
+}
+
+static void testTwoFinger() {
+    Replay replay;
+    CHECK(replay.run("two-finger"));
+    CHECK_EQUAL(replay.multitouchFrames, 20);
+
+    // The second finger ends the single finger gesture without a click or a hold
+    CHECK_EQUAL(replay.countButton(kGoodixGestureButtonLeft), 0);
+    CHECK_EQUAL(replay.countButton(kGoodixGestureButtonRight), 0);
+    int lifted = replay.find(kGoodixGestureLifted);
+    CHECK(lifted >= 0);
+    CHECK_EQUAL(replay.commands[lifted].at, 210 * MS);
+    CHECK(!replay.isMultitouch);
+}
+
+static void testLongPress() {
+    Replay replay;
+    CHECK(replay.run("long-press"));
+
+    // Right clicked exactly RIGHT_CLICK_DELAY after the finger went down, and only once
+    int right = replay.find(kGoodixGestureDispatch, kGoodixGestureButtonRight);
+    CHECK(right >= 0);
+    CHECK_EQUAL(replay.commands[right].at, RIGHT_CLICK_DELAY * MS);
+    CHECK_EQUAL(replay.commands[right].x, 800);
+    CHECK_EQUAL(replay.commands[right].y, 600);
+    CHECK_EQUAL(replay.countButton(kGoodixGestureButtonRight), 1);
+    CHECK_EQUAL(replay.countButton(kGoodixGestureButtonLeft), 0);
+
+    int lifted = replay.find(kGoodixGestureLifted);
+    CHECK(lifted > right);
+    CHECK_EQUAL(replay.commands[lifted].at, 710 * MS);
+}
+
+int main() {
+    testTap();
+    testDrag();
+    testTwoFinger();
+    testLongPress();
+    return TEST_RESULT();
+}
@@ -0,0 +1,91 @@
+//
+//  TransformTests.cpp
+//  VoodooI2CGoodix
+//
+//  Created by agent on 10/17/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include "VoodooI2CGoodixTransform.hpp"
+#include "TestHelpers.hpp"
+
+#define EXTENT  65535
+
+// Every one of the 8 display rotations maps the whole panel onto 0 to EXTENT, and the corners onto the corners
+static void testRotateAndScaleStaysInRange(int maxX, int maxY) {
+    for (int rotation = 0; rotation < 8; rotation++) {
+        bool swap = rotation & 1, invertX = rotation & 2, invertY = rotation & 4;
+        VoodooI2CGoodixTransform transform = VoodooI2CGoodixTransform::rotateAndScale(maxX, maxY, swap, invertX, invertY, EXTENT);
+
+        int outOfRange = 0;
+        for (int x = 0; x <= maxX; x++) {
+            for (int y = 0; y <= maxY; y += x == 0 || x == maxX ? 1 : maxY) {
+                int outX, outY;
+                transform.apply(x, y, &outX, &outY);
+                if (outX < 0 || outX > EXTENT || outY < 0 || outY > EXTENT) {
+                    outOfRange++;
+                }
+            }
+        }
+        CHECK_EQUAL(outOfRange, 0);
+
+        int outX, outY;
+        transform.apply(0, 0, &outX, &outY);
+        CHECK_EQUAL(outX, invertX ? EXTENT : 0);
+        CHECK_EQUAL(outY, invertY ? EXTENT : 0);
+        transform.apply(maxX, maxY, &outX, &outY);
+        CHECK_EQUAL(outX, invertX ? 0 : EXTENT);
+        CHECK_EQUAL(outY, invertY ? 0 : EXTENT);
+
+        // X moves along the panel's Y once the axes are swapped
+        transform.apply(maxX, 0, &outX, &outY);
+        if (swap) {
+            CHECK_EQUAL(outX, invertX ? EXTENT : 0);
+            CHECK_EQUAL(outY, invertY ? 0 : EXTENT);
+        }
+        else {
+            CHECK_EQUAL(outX, invertX ? 0 : EXTENT);
+            CHECK_EQUAL(outY, invertY ? EXTENT : 0);
+        }
+    }
+}
+
+static void testRotateAndScaleMatchesIntegerMath() {
+    VoodooI2CGoodixTransform transform = VoodooI2CGoodixTransform::rotateAndScale(1280, 800, true, true, false, EXTENT);
+    for (int x = 0; x <= 1280; x += 7) {
+        for (int y = 0; y <= 800; y += 13) {
+            int outX, outY;
+            transform.apply(x, y, &outX, &outY);
+            CHECK_EQUAL(outX, EXTENT * (800 - y) / 800);
+            CHECK_EQUAL(outY, EXTENT * x / 1280);
+        }
+    }
+}
+
+static void testClamp() {
+    VoodooI2CGoodixTransform offset = VoodooI2CGoodixTransform::calibration(0x10000, 0, 0, 0x10000, -10, 10);
+    VoodooI2CGoodixTransform transform = VoodooI2CGoodixTransform::swapAxes().then(offset.clampedTo(800, 1280));
+
+    int outX, outY;
+    transform.apply(1280, 5, &outX, &outY);
+    CHECK_EQUAL(outX, 0);
+    CHECK_EQUAL(outY, 1280);
+    transform.apply(640, 400, &outX, &outY);
+    CHECK_EQUAL(outX, 390);
+    CHECK_EQUAL(outY, 650);
+
+    // A step after the clamp replaces it
+    transform = transform.then(VoodooI2CGoodixTransform::invert(true, false, 800, 1280));
+    transform.apply(1280, 5, &outX, &outY);
+    CHECK_EQUAL(outX, 800 + 5);
+}
+
+int main() {
+    testRotateAndScaleStaysInRange(1280, 800);
+    testRotateAndScaleStaysInRange(1920, 1080);
+    testRotateAndScaleStaysInRange(4095, 4095);
+    testRotateAndScaleStaysInRange(1, 1);
+    testRotateAndScaleMatchesIntegerMath();
+    testClamp();
+    return TEST_RESULT();
+}
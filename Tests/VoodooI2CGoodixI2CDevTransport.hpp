@@ -0,0 +1,100 @@
+//
+//  VoodooI2CGoodixI2CDevTransport.hpp
+//  VoodooI2CGoodix
+//
+//  Created by agent on 10/17/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef VoodooI2CGoodixI2CDevTransport_hpp
+#define VoodooI2CGoodixI2CDevTransport_hpp
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+#include "VoodooI2CGoodixTransport.hpp"
+
+/* The panel on a Linux i2c-dev bus, i.e. /dev/i2c-1
+ *
+ * Registers are addressed with 16 bit big-endian addresses, like the kext's I2C transport does it.
+ * The panel has to be unbound from the kernel's goodix driver first, or the reads race with it.
+ */
+
+class VoodooI2CGoodixI2CDevTransport : public VoodooI2CGoodixTransport {
+ public:
+    VoodooI2CGoodixI2CDevTransport() : fd(-1), address(0) {}
+
+    ~VoodooI2CGoodixI2CDevTransport() override {
+        close();
+    }
+
+    /* @path The i2c-dev device of the bus
+     * @deviceAddress The panel's 7 bit address, 0x5d or 0x14
+     *
+     * @return true if the bus could be opened
+     */
+
+    bool open(const char* path, UInt16 deviceAddress) {
+        close();
+        fd = ::open(path, O_RDWR);
+        address = deviceAddress;
+        return fd >= 0;
+    }
+
+    void close() {
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+
+    IOReturn readVersion(UInt8* values, size_t len) override {
+        return readRegisters(GOODIX_REG_ID, values, len);
+    }
+
+    IOReturn readConfig(UInt16 reg, UInt8* values, size_t len) override {
+        return readRegisters(reg, values, len);
+    }
+
+    IOReturn readReport(UInt16 offset, UInt8* values, size_t len) override {
+        return readRegisters(GOODIX_READ_COOR_ADDR + offset, values, len);
+    }
+
+    IOReturn endCmd() override {
+        UInt8 zero = 0;
+        return writeRegisters(GOODIX_READ_COOR_ADDR, &zero, 1);
+    }
+
+    IOReturn readRegisters(UInt16 reg, UInt8* values, size_t len) {
+        UInt8 address_bytes[2] = {(UInt8)(reg >> 8), (UInt8)(reg & 0xff)};
+        struct i2c_msg msgs[2] = {
+            {address, 0, sizeof(address_bytes), address_bytes},
+            {address, I2C_M_RD, (UInt16)len, values}
+        };
+        struct i2c_rdwr_ioctl_data transfer = {msgs, 2};
+        return ioctl(fd, I2C_RDWR, &transfer) == 2 ? kIOReturnSuccess : kIOReturnIOError;
+    }
+
+    IOReturn writeRegisters(UInt16 reg, const UInt8* values, size_t len) {
+        UInt8 buffer[2 + GOODIX_CONFIG_MAX_LENGTH];
+        if (len > GOODIX_CONFIG_MAX_LENGTH) {
+            return kIOReturnBadArgument;
+        }
+        buffer[0] = reg >> 8;
+        buffer[1] = reg & 0xff;
+        memcpy(buffer + 2, values, len);
+
+        struct i2c_msg msg = {address, 0, (UInt16)(len + 2), buffer};
+        struct i2c_rdwr_ioctl_data transfer = {&msg, 1};
+        return ioctl(fd, I2C_RDWR, &transfer) == 1 ? kIOReturnSuccess : kIOReturnIOError;
+    }
+
+ private:
+    int fd;
+    UInt16 address;
+};
+
+#endif /* VoodooI2CGoodixI2CDevTransport_hpp */
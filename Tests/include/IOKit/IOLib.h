@@ -0,0 +1,28 @@
+//
+//  IOLib.h
+//  VoodooI2CGoodix
+//
+//  Created by agent on 10/17/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+// Stands in for the kernel's IOKit/IOLib.h when the portable sources are built on the host
+
+#ifndef IOLib_h
+#define IOLib_h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <libkern/OSTypes.h>
+
+static inline void* IOMalloc(size_t size) {
+    return malloc(size);
+}
+
+static inline void IOFree(void* address, size_t) {
+    free(address);
+}
+
+#define IOLog(...) fprintf(stderr, __VA_ARGS__)
+
+#endif /* IOLib_h */
@@ -0,0 +1,23 @@
+//
+//  IOReturn.h
+//  VoodooI2CGoodix
+//
+//  Created by agent on 10/17/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+// Stands in for the kernel's IOKit/IOReturn.h when the portable sources are built on the host
+
+#ifndef IOReturn_h
+#define IOReturn_h
+
+typedef int IOReturn;
+
+#define kIOReturnSuccess        0
+#define kIOReturnError          ((IOReturn)0xe00002bc)
+#define kIOReturnNoMemory       ((IOReturn)0xe00002bd)
+#define kIOReturnBadArgument    ((IOReturn)0xe00002c2)
+#define kIOReturnIOError        ((IOReturn)0xe00002ca)
+#define kIOReturnNotFound       ((IOReturn)0xe00002f0)
+
+#endif /* IOReturn_h */
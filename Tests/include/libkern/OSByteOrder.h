@@ -0,0 +1,30 @@
+//
+//  OSByteOrder.h
+//  VoodooI2CGoodix
+//
+//  Created by agent on 10/17/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+// Stands in for the kernel's libkern/OSByteOrder.h when the portable sources are built on the host
+
+#ifndef OSByteOrder_h
+#define OSByteOrder_h
+
+#include <libkern/OSTypes.h>
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define OSSwapHostToLittleInt16(x)  ((UInt16)(x))
+#define OSSwapHostToLittleInt32(x)  ((UInt32)(x))
+#define OSSwapHostToLittleInt64(x)  ((UInt64)(x))
+#else
+#define OSSwapHostToLittleInt16(x)  __builtin_bswap16(x)
+#define OSSwapHostToLittleInt32(x)  __builtin_bswap32(x)
+#define OSSwapHostToLittleInt64(x)  __builtin_bswap64(x)
+#endif
+
+#define OSSwapLittleToHostInt16(x)  OSSwapHostToLittleInt16(x)
+#define OSSwapLittleToHostInt32(x)  OSSwapHostToLittleInt32(x)
+#define OSSwapLittleToHostInt64(x)  OSSwapHostToLittleInt64(x)
+
+#endif /* OSByteOrder_h */
@@ -0,0 +1,29 @@
+//
+//  OSTypes.h
+//  VoodooI2CGoodix
+//
+//  Created by agent on 10/17/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+// Stands in for the kernel's libkern/OSTypes.h when the portable sources are built on the host
+
+#ifndef OSTypes_h
+#define OSTypes_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint8_t UInt8;
+typedef uint16_t UInt16;
+typedef uint32_t UInt32;
+typedef uint64_t UInt64;
+typedef int8_t SInt8;
+typedef int16_t SInt16;
+typedef int32_t SInt32;
+typedef int64_t SInt64;
+
+// VoodooI2C's helpers.hpp defines this for the kext
+#define BIT(x) (1UL << (x))
+
+#endif /* OSTypes_h */
@@ -0,0 +1,59 @@
+//
+//  VoodooI2CGoodixClock.cpp
+//  VoodooI2CGoodix
+//
+//  Created by agent on 10/17/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include "VoodooI2CGoodixClock.hpp"
+#include <IOKit/IOLib.h>
+
+bool VoodooI2CGoodixSystemClock::start(OSObject* owner, IOWorkLoop* loop) {
+    workLoop = loop;
+    timer = IOTimerEventSource::timerEventSource(owner, &VoodooI2CGoodixSystemClock::timerFired);
+    if (!timer) {
+        return false;
+    }
+    timer->setRefcon(this);
+    if (workLoop->addEventSource(timer) != kIOReturnSuccess) {
+        OSSafeReleaseNULL(timer);
+        return false;
+    }
+    return true;
+}
+
+void VoodooI2CGoodixSystemClock::stop() {
+    if (timer) {
+        timer->cancelTimeout();
+        workLoop->removeEventSource(timer);
+        OSSafeReleaseNULL(timer);
+    }
+    workLoop = NULL;
+}
+
+UInt64 VoodooI2CGoodixSystemClock::getNanoseconds() {
+    AbsoluteTime timestamp;
+    UInt64 nanoseconds;
+    clock_get_uptime(&timestamp);
+    absolutetime_to_nanoseconds(timestamp, &nanoseconds);
+    return nanoseconds;
+}
+
+void VoodooI2CGoodixSystemClock::setWakeup(UInt64 deadline) {
+    if (!timer) {
+        return;
+    }
+    if (deadline == GOODIX_CLOCK_NEVER) {
+        timer->cancelTimeout();
+        return;
+    }
+    AbsoluteTime time;
+    nanoseconds_to_absolutetime(deadline, &time);
+    timer->wakeAtTime(time);
+}
+
+void VoodooI2CGoodixSystemClock::timerFired(OSObject* owner, IOTimerEventSource* sender) {
+    VoodooI2CGoodixSystemClock* clock = (VoodooI2CGoodixSystemClock*)sender->getRefcon();
+    clock->fireDue(clock->getNanoseconds());
+}
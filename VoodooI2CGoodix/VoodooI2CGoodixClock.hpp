@@ -0,0 +1,265 @@
+//
+//  VoodooI2CGoodixClock.hpp
+//  VoodooI2CGoodix
+//
+//  Created by agent on 10/17/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef VoodooI2CGoodixClock_hpp
+#define VoodooI2CGoodixClock_hpp
+
+#include <stddef.h>
+#include <libkern/OSTypes.h>
+
+/* The wakeup deadline when no timer is armed */
+#define GOODIX_CLOCK_NEVER  (~0ULL)
+
+enum VoodooI2CGoodixTimerID {
+    kGoodixTimerLift,       // lifts the fingers if the panel's lift report is lost
+    kGoodixTimerClick,      // checks for a click once the finger has been still for CLICK_DELAY
+    kGoodixTimerHold,       // right clicks once the finger has been down without moving for RIGHT_CLICK_DELAY
+    kGoodixTimerCount
+};
+
+/* Called when a timer's deadline passes
+ * @target The target the clock was given
+ * @timer The timer that fired
+ */
+
+typedef void (*VoodooI2CGoodixTimerAction)(void* target, VoodooI2CGoodixTimerID timer);
+
+/* A monotonic clock in nanoseconds, and one-shot timers that fire at a deadline on that clock
+ *
+ * The event driver reads time and arms its timers only through this, so the same gesture logic
+ * can run against uptime and the work loop, or against a <VoodooI2CGoodixVirtualClock> that
+ * moves only when it's told to. Every timer's deadline is kept here, and a clock only has to
+ * wake up once for the earliest of them, which is reprogrammed only when it changes.
+ */
+
+class VoodooI2CGoodixClock {
+ public:
+    VoodooI2CGoodixClock() : action(NULL), target(NULL), armed(0), wakeup(GOODIX_CLOCK_NEVER), firing(false) {}
+
+    virtual ~VoodooI2CGoodixClock() {}
+
+    /* Set what's called when a timer fires
+     */
+
+    void setAction(VoodooI2CGoodixTimerAction newAction, void* newTarget) {
+        action = newAction;
+        target = newTarget;
+    }
+
+    /* The current time in nanoseconds
+     */
+
+    virtual UInt64 getNanoseconds() = 0;
+
+    /* Arm a timer, replacing its previous deadline if it was already armed
+     * @timer The timer to arm
+     * @deadline When the timer should fire, in nanoseconds on this clock
+     */
+
+    void setDeadline(VoodooI2CGoodixTimerID timer, UInt64 deadline) {
+        deadlines[timer] = deadline;
+        armed |= 1 << timer;
+        updateWakeup();
+    }
+
+    /* Disarm a timer, does nothing if it isn't armed
+     */
+
+    void cancel(VoodooI2CGoodixTimerID timer) {
+        if (!(armed & (1 << timer))) {
+            return;
+        }
+        armed &= ~(1 << timer);
+        updateWakeup();
+    }
+
+    bool isArmed(VoodooI2CGoodixTimerID timer) const {
+        return armed & (1 << timer);
+    }
+
+ protected:
+    /* Wake up at a deadline, replacing the previous one
+     * @deadline The earliest deadline of the armed timers, or GOODIX_CLOCK_NEVER to not wake up
+     */
+
+    virtual void setWakeup(UInt64 deadline) = 0;
+
+    /* The armed timer with the earliest deadline at or before a time, or -1
+     */
+
+    int nextDue(UInt64 time) const {
+        int due = -1;
+        for (int i = 0; i < kGoodixTimerCount; i++) {
+            if ((armed & (1 << i)) && deadlines[i] <= time && (due < 0 || deadlines[i] < deadlines[due])) {
+                due = i;
+            }
+        }
+        return due;
+    }
+
+    UInt64 getDeadline(VoodooI2CGoodixTimerID timer) const {
+        return deadlines[timer];
+    }
+
+    /* Disarm a timer and call the action for it
+     */
+
+    void fire(VoodooI2CGoodixTimerID timer) {
+        armed &= ~(1 << timer);
+        if (action) {
+            action(target, timer);
+        }
+    }
+
+    /* Fire every timer that's due in deadline order, then wake up for the next one
+     * @time The current time
+     *
+     * Called when the wakeup passes. Timers that are re-armed by others firing are handled in
+     * the same call, and the wakeup is only programmed once at the end.
+     */
+
+    void fireDue(UInt64 time) {
+        int timer;
+        wakeup = GOODIX_CLOCK_NEVER;
+        firing = true;
+        while ((timer = nextDue(time)) >= 0) {
+            fire((VoodooI2CGoodixTimerID)timer);
+        }
+        firing = false;
+        updateWakeup();
+    }
+
+ private:
+    VoodooI2CGoodixTimerAction action;
+    void* target;
+
+    UInt64 deadlines[kGoodixTimerCount];
+    UInt32 armed;
+
+    // The deadline the clock was last told to wake up at
+    UInt64 wakeup;
+    bool firing;
+
+    void updateWakeup() {
+        if (firing) {
+            return;
+        }
+
+        UInt64 earliest = GOODIX_CLOCK_NEVER;
+        for (int i = 0; i < kGoodixTimerCount; i++) {
+            if ((armed & (1 << i)) && deadlines[i] < earliest) {
+                earliest = deadlines[i];
+            }
+        }
+
+        if (earliest != wakeup) {
+            wakeup = earliest;
+            setWakeup(earliest);
+        }
+    }
+};
+
+/* A clock that only moves when <advance> is called, firing the timers it passes in deadline order
+ *
+ * Has no dependencies on IOKit, so recorded frames can be replayed through the event driver's
+ * gesture logic as fast as they can be processed.
+ */
+
+class VoodooI2CGoodixVirtualClock : public VoodooI2CGoodixClock {
+ public:
+    explicit VoodooI2CGoodixVirtualClock(UInt64 start = 0) : now(start) {}
+
+    UInt64 getNanoseconds() override {
+        return now;
+    }
+
+    /* Move the clock to a time, firing every timer whose deadline comes before it
+     * @time The time to move to, the clock never goes backwards
+     *
+     * The clock reads each timer's deadline while it fires, so timers that are re-armed by
+     * others firing are handled in the same call.
+     */
+
+    void advanceTo(UInt64 time) {
+        int timer;
+        while ((timer = nextDue(time)) >= 0) {
+            UInt64 deadline = getDeadline((VoodooI2CGoodixTimerID)timer);
+            if (deadline > now) {
+                now = deadline;
+            }
+            fire((VoodooI2CGoodixTimerID)timer);
+        }
+        if (time > now) {
+            now = time;
+        }
+    }
+
+    void advance(UInt64 nanoseconds) {
+        advanceTo(now + nanoseconds);
+    }
+
+    /* Disarm every timer and move the clock to a time, which can be earlier than the current one
+     * @time The time to start over at
+     */
+
+    void reset(UInt64 time) {
+        for (int i = 0; i < kGoodixTimerCount; i++) {
+            cancel((VoodooI2CGoodixTimerID)i);
+        }
+        now = time;
+    }
+
+ protected:
+    // Timers only fire when the clock is advanced
+    void setWakeup(UInt64) override {}
+
+ private:
+    UInt64 now;
+};
+
+#ifdef KERNEL
+
+#include <IOKit/IOWorkLoop.h>
+#include <IOKit/IOTimerEventSource.h>
+
+/* Uptime, with a single IOTimerEventSource on the owner's work loop for the earliest deadline
+ */
+
+class VoodooI2CGoodixSystemClock : public VoodooI2CGoodixClock {
+ public:
+    VoodooI2CGoodixSystemClock() : workLoop(NULL), timer(NULL) {}
+
+    /* Add the timer to a work loop
+     * @owner The object the timer belongs to
+     * @loop The work loop the timers fire on
+     *
+     * @return false if the timer could not be created or added, <stop> must still be called
+     */
+
+    bool start(OSObject* owner, IOWorkLoop* loop);
+
+    /* Cancel the timer and remove it from the work loop
+     */
+
+    void stop();
+
+    UInt64 getNanoseconds() override;
+
+ protected:
+    void setWakeup(UInt64 deadline) override;
+
+ private:
+    IOWorkLoop* workLoop;
+    IOTimerEventSource* timer;
+
+    static void timerFired(OSObject* owner, IOTimerEventSource* sender);
+};
+
+#endif /* KERNEL */
+
+#endif /* VoodooI2CGoodixClock_hpp */
@@ -0,0 +1,155 @@
+//
+//  VoodooI2CGoodixContactTracker.hpp
+//  VoodooI2CGoodix
+//
+//  Created by agent on 10/17/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef VoodooI2CGoodixContactTracker_hpp
+#define VoodooI2CGoodixContactTracker_hpp
+
+#include <libkern/OSTypes.h>
+#include "goodix.h"
+
+struct Touch {
+    int x;
+    int y;
+    int width;
+    bool type; // 0 = finger, 1 = pen
+    UInt8 id; // track ID assigned by the panel, 0 to GOODIX_MAX_CONTACTS - 1
+};
+
+enum VoodooI2CGoodixContactState {
+    kGoodixContactDown,
+    kGoodixContactMove,
+    kGoodixContactUp
+};
+
+struct VoodooI2CGoodixContact {
+    Touch touch;
+    UInt8 slot;
+    VoodooI2CGoodixContactState state;
+};
+
+/* Follows contacts from frame to frame by the track ID the panel gives them
+ *
+ * A contact is given the lowest free slot when it goes down, and keeps it until it goes up, so
+ * slots can be used as stable transducer indexes. Each <update> produces one transition per
+ * contact: down or move for the contacts in the frame, and up for the ones that left it.
+ */
+
+class VoodooI2CGoodixContactTracker {
+ public:
+    VoodooI2CGoodixContactTracker() {
+        reset();
+    }
+
+    /* Forget every contact without producing transitions
+     */
+
+    void reset() {
+        for (int i = 0; i < GOODIX_MAX_CONTACTS; i++) {
+            slotForId[i] = -1;
+        }
+        usedSlots = 0;
+        activeIds = 0;
+        count = 0;
+    }
+
+    /* Match a frame's contacts to slots
+     * @touches The contacts in the frame
+     * @numTouches The number of contacts in the frame
+     *
+     * @return the number of transitions, which are read with <getContacts>
+     */
+
+    int update(const Touch touches[], int numTouches) {
+        UInt16 seenIds = 0;
+        count = 0;
+
+        for (int i = 0; i < numTouches; i++) {
+            UInt8 id = touches[i].id;
+            if (id >= GOODIX_MAX_CONTACTS || (seenIds & (1 << id))) {
+                continue;
+            }
+            seenIds |= 1 << id;
+
+            VoodooI2CGoodixContactState state = kGoodixContactMove;
+            if (slotForId[id] < 0) {
+                slotForId[id] = lowestFreeSlot();
+                usedSlots |= 1 << slotForId[id];
+                state = kGoodixContactDown;
+            }
+
+            lastTouches[id] = touches[i];
+            addContact(lastTouches[id], slotForId[id], state);
+        }
+
+        releaseIds(activeIds & ~seenIds);
+        activeIds = seenIds;
+        return count;
+    }
+
+    /* Lift every contact
+     *
+     * @return the number of transitions, which are read with <getContacts>
+     */
+
+    int liftAll() {
+        count = 0;
+        releaseIds(activeIds);
+        activeIds = 0;
+        return count;
+    }
+
+    /* The transitions produced by the last <update> or <liftAll>
+     */
+
+    const VoodooI2CGoodixContact* getContacts() const {
+        return contacts;
+    }
+
+    /* The number of contacts that are down
+     */
+
+    int getActiveCount() const {
+        return __builtin_popcount(activeIds);
+    }
+
+ private:
+    SInt8 slotForId[GOODIX_MAX_CONTACTS];
+    Touch lastTouches[GOODIX_MAX_CONTACTS];
+    UInt16 usedSlots;
+    UInt16 activeIds;
+
+    VoodooI2CGoodixContact contacts[GOODIX_MAX_CONTACTS];
+    int count;
+
+    SInt8 lowestFreeSlot() const {
+        // There are as many slots as track IDs, so one is always free
+        return __builtin_ctz(~usedSlots);
+    }
+
+    void addContact(const Touch& touch, SInt8 slot, VoodooI2CGoodixContactState state) {
+        VoodooI2CGoodixContact& contact = contacts[count++];
+        contact.touch = touch;
+        contact.slot = slot;
+        contact.state = state;
+    }
+
+    void releaseIds(UInt16 ids) {
+        for (int id = 0; id < GOODIX_MAX_CONTACTS; id++) {
+            if (!(ids & (1 << id))) {
+                continue;
+            }
+
+            // The contact goes up where it was last seen
+            addContact(lastTouches[id], slotForId[id], kGoodixContactUp);
+            usedSlots &= ~(1 << slotForId[id]);
+            slotForId[id] = -1;
+        }
+    }
+};
+
+#endif /* VoodooI2CGoodixContactTracker_hpp */
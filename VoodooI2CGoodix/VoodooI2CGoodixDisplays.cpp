@@ -0,0 +1,150 @@
+//
+//  VoodooI2CGoodixDisplays.cpp
+//  VoodooI2CGoodix
+//
+//  Created by agent on 10/17/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include "VoodooI2CGoodixDisplays.hpp"
+
+static UInt32 getNumberProperty(IOService* service, const char* key) {
+    OSNumber* number = OSDynamicCast(OSNumber, service->getProperty(key));
+    return number ? number->unsigned32BitValue() : 0;
+}
+
+bool VoodooI2CGoodixDisplays::setPreferred(UInt32 vendorID, UInt32 productID) {
+    VoodooI2CGoodixDisplay* previous = active;
+    preferredVendorID = vendorID;
+    preferredProductID = productID;
+    select();
+    return active != previous;
+}
+
+void VoodooI2CGoodixDisplays::setLogicalSize(int maxX, int maxY) {
+    logicalMaxX = maxX;
+    logicalMaxY = maxY;
+    defaultTransform = VoodooI2CGoodixTransform::scaleTo(logicalMaxX, logicalMaxY, 65535);
+    for (int i = 0; i < count; i++) {
+        buildTransform(displays[i]);
+    }
+}
+
+bool VoodooI2CGoodixDisplays::add(IOService* display, IOFramebuffer* framebuffer) {
+    if (count == GOODIX_MAX_DISPLAYS) {
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        if (displays[i].display == display) {
+            return false;
+        }
+    }
+
+    VoodooI2CGoodixDisplay& entry = displays[count++];
+    display->retain();
+    framebuffer->retain();
+    entry.display = display;
+    entry.framebuffer = framebuffer;
+    entry.vendorID = getNumberProperty(display, "DisplayVendorID");
+    entry.productID = getNumberProperty(display, "DisplayProductID");
+
+    // Built-in panels are driven as backlit displays
+    entry.internal = display->metaCast("AppleBacklightDisplay") != NULL;
+
+    readRotation(entry);
+    buildTransform(entry);
+
+    VoodooI2CGoodixDisplay* previous = active;
+    select();
+    return active != previous;
+}
+
+bool VoodooI2CGoodixDisplays::remove(IOService* display) {
+    for (int i = 0; i < count; i++) {
+        if (displays[i].display != display) {
+            continue;
+        }
+
+        IOService* previous = active ? active->display : NULL;
+        displays[i].display->release();
+        displays[i].framebuffer->release();
+
+        // Keep the displays in the order they were connected, which moves the active one
+        for (int j = i; j < count - 1; j++) {
+            displays[j] = displays[j + 1];
+        }
+        count--;
+
+        select();
+        return (active ? active->display : NULL) != previous;
+    }
+    return false;
+}
+
+void VoodooI2CGoodixDisplays::removeAll() {
+    for (int i = 0; i < count; i++) {
+        displays[i].display->release();
+        displays[i].framebuffer->release();
+    }
+    count = 0;
+    active = NULL;
+}
+
+bool VoodooI2CGoodixDisplays::updateRotation(IOFramebuffer* framebuffer) {
+    bool changed = false;
+    for (int i = 0; i < count; i++) {
+        if (displays[i].framebuffer != framebuffer) {
+            continue;
+        }
+
+        UInt8 rotation = displays[i].rotation;
+        readRotation(displays[i]);
+        if (displays[i].rotation != rotation) {
+            buildTransform(displays[i]);
+            changed = changed || active == &displays[i];
+        }
+    }
+    return changed;
+}
+
+void VoodooI2CGoodixDisplays::readRotation(VoodooI2CGoodixDisplay& display) {
+    OSNumber* number = OSDynamicCast(OSNumber, display.framebuffer->getProperty(kIOFBTransformKey));
+    display.rotation = number ? number->unsigned8BitValue() / 0x10 : 0;
+}
+
+void VoodooI2CGoodixDisplays::buildTransform(VoodooI2CGoodixDisplay& display) {
+    // Swaps the axes before inverting them, like the framebuffer
+    display.pointerTransform = VoodooI2CGoodixTransform::rotateAndScale(logicalMaxX, logicalMaxY, display.rotation & kIOFBSwapAxes,
+                                                                        display.rotation & kIOFBInvertX, display.rotation & kIOFBInvertY, 65535);
+}
+
+bool VoodooI2CGoodixDisplays::isPreferred(const VoodooI2CGoodixDisplay& display) const {
+    if (!preferredVendorID) {
+        return false;
+    }
+    return display.vendorID == preferredVendorID && (!preferredProductID || display.productID == preferredProductID);
+}
+
+void VoodooI2CGoodixDisplays::select() {
+    VoodooI2CGoodixDisplay* internal = NULL;
+    VoodooI2CGoodixDisplay* preferred = NULL;
+
+    for (int i = 0; i < count; i++) {
+        if (!preferred && isPreferred(displays[i])) {
+            preferred = &displays[i];
+        }
+        if (!internal && displays[i].internal) {
+            internal = &displays[i];
+        }
+    }
+
+    if (preferred) {
+        active = preferred;
+    }
+    else if (internal) {
+        active = internal;
+    }
+    else {
+        active = count ? &displays[0] : NULL;
+    }
+}
@@ -0,0 +1,131 @@
+//
+//  VoodooI2CGoodixDisplays.hpp
+//  VoodooI2CGoodix
+//
+//  Created by agent on 10/17/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef VoodooI2CGoodixDisplays_hpp
+#define VoodooI2CGoodixDisplays_hpp
+
+#include <IOKit/IOService.h>
+#include <IOKit/graphics/IOFramebuffer.h>
+#include "./VoodooI2CGoodixTransform.hpp"
+
+#define GOODIX_MAX_DISPLAYS 8
+
+struct VoodooI2CGoodixDisplay {
+    IOService* display;
+    IOFramebuffer* framebuffer;
+    UInt32 vendorID;
+    UInt32 productID;
+    bool internal;
+    UInt8 rotation;
+
+    // Scales logical coordinates to IOFixed and rotates them to this display
+    VoodooI2CGoodixTransform pointerTransform;
+};
+
+/* Picks the display the touchscreen is mounted on out of every display that's connected
+ *
+ * A display whose IDs match the configured ones wins, then the internal panel, then the display
+ * that was connected first. Every display keeps its own pointer transform, so following another
+ * display or a rotation on the input path is just a pointer change. Not thread safe, every call
+ * has to be made on the owner's work loop.
+ */
+
+class VoodooI2CGoodixDisplays {
+ public:
+    VoodooI2CGoodixDisplays() : count(0), active(NULL), preferredVendorID(0), preferredProductID(0), logicalMaxX(0), logicalMaxY(0) {
+        defaultTransform = VoodooI2CGoodixTransform::scaleTo(0, 0, 65535);
+    }
+
+    /* Prefer a display by its IDs
+     * @vendorID The DisplayVendorID of the display, or 0 to prefer the internal panel
+     * @productID The DisplayProductID of the display, or 0 to match any display from the vendor
+     *
+     * @return true if the active display changed
+     */
+
+    bool setPreferred(UInt32 vendorID, UInt32 productID);
+
+    /* Set the panel's logical size and rebuild every pointer transform
+     */
+
+    void setLogicalSize(int maxX, int maxY);
+
+    /* Start tracking a display that was connected
+     * @display The IODisplay
+     * @framebuffer The framebuffer it's attached to
+     *
+     * @return true if the active display changed
+     */
+
+    bool add(IOService* display, IOFramebuffer* framebuffer);
+
+    /* Stop tracking a display that was disconnected
+     *
+     * @return true if the active display changed
+     */
+
+    bool remove(IOService* display);
+
+    /* Forget every display
+     */
+
+    void removeAll();
+
+    /* Read the rotation of a framebuffer after its mode changed
+     *
+     * @return true if the rotation of the active display changed
+     */
+
+    bool updateRotation(IOFramebuffer* framebuffer);
+
+    /* The display the touchscreen is on, or NULL if there is none
+     */
+
+    const VoodooI2CGoodixDisplay* getActive() const {
+        return active;
+    }
+
+    /* The pointer transform of the active display, or an unrotated one if there is none
+     */
+
+    inline const VoodooI2CGoodixTransform& getPointerTransform() const {
+        return active ? active->pointerTransform : defaultTransform;
+    }
+
+    /* The rotation of the active display, kIOFBSwapAxes, kIOFBInvertX and kIOFBInvertY
+     */
+
+    UInt8 getRotation() const {
+        return active ? active->rotation : 0;
+    }
+
+ private:
+    VoodooI2CGoodixDisplay displays[GOODIX_MAX_DISPLAYS];
+    int count;
+    VoodooI2CGoodixDisplay* active;
+
+    UInt32 preferredVendorID;
+    UInt32 preferredProductID;
+
+    int logicalMaxX;
+    int logicalMaxY;
+    VoodooI2CGoodixTransform defaultTransform;
+
+    void readRotation(VoodooI2CGoodixDisplay& display);
+
+    void buildTransform(VoodooI2CGoodixDisplay& display);
+
+    bool isPreferred(const VoodooI2CGoodixDisplay& display) const;
+
+    /* Pick the active display again
+     */
+
+    void select();
+};
+
+#endif /* VoodooI2CGoodixDisplays_hpp */
@@ -11,29 +11,28 @@
 #include <IOKit/IOLib.h>
 
 #define super IOHIDEventService
+
+static_assert(HOVER == kGoodixGestureButtonNone && LEFT_CLICK == kGoodixGestureButtonLeft && RIGHT_CLICK == kGoodixGestureButtonRight, "Gesture buttons must match the click types");
 OSDefineMetaClassAndStructors(VoodooI2CGoodixEventDriver, IOHIDEventService);
 
-static UInt64 getNanoseconds() {
-    AbsoluteTime timestamp;
-    UInt64 nanoseconds;
-    clock_get_uptime(&timestamp);
-    absolutetime_to_nanoseconds(timestamp, &nanoseconds);
-    return nanoseconds;
+// The pointer transform is built for coordinates on the panel
+static int clampToPanel(int logical, int logicalMax) {
+    if (logical <= 0) {
+        return 0;
+    }
+    return logical > logicalMax ? logicalMax : logical;
 }
 
 void VoodooI2CGoodixEventDriver::dispatchPenEvent(int logicalX, int logicalY, int pressure, UInt32 clickType) {
-    AbsoluteTime timestamp;
-    clock_get_uptime(&timestamp);
-
-    // Convert logical coordinates to IOFixed and Scaled;
-    IOFixed x = ((logicalX * 1.0f) / multitouch_interface->logical_max_x) * 65535;
-    IOFixed y = ((logicalY * 1.0f) / multitouch_interface->logical_max_y) * 65535;
-    IOFixed tipPressure = ((pressure * 1.0f) / 1024) * 65535;
+    // Convert logical coordinates to IOFixed, scaled and rotated to the display
+    IOFixed x, y;
+    displays.getPointerTransform().apply(clampToPanel(logicalX, logicalMaxX), clampToPanel(logicalY, logicalMaxY), &x, &y);
 
-    checkRotation(&x, &y);
+    // The panel reports pressure as a 16 bit width, which overflows an int once scaled
+    IOFixed tipPressure = (IOFixed)(((SInt64)pressure * 65535) >> 10);
 
     // Dispatch the actual event
-    dispatchDigitizerEventWithTiltOrientation(timestamp, stylusTransducerID, kDigitiserTransducerStylus, 0x1, clickType, x, y, 0, tipPressure);
+    dispatchDigitizerEventWithTiltOrientation(eventTimestamp, stylusTransducerID, kDigitiserTransducerStylus, 0x1, clickType, x, y, 0, tipPressure);
 
     // Store the coordinates so we can lift the finger later
     lastEventFixedX = x;
@@ -41,71 +40,42 @@ void VoodooI2CGoodixEventDriver::dispatchPenEvent(int logicalX, int logicalY, in
 }
 
 void VoodooI2CGoodixEventDriver::dispatchDigitizerEvent(int logicalX, int logicalY, UInt32 clickType) {
-    AbsoluteTime timestamp;
-    clock_get_uptime(&timestamp);
-
-    // Convert logical coordinates to IOFixed and Scaled;
-    IOFixed x = ((logicalX * 1.0f) / multitouch_interface->logical_max_x) * 65535;
-    IOFixed y = ((logicalY * 1.0f) / multitouch_interface->logical_max_y) * 65535;
-
-    checkRotation(&x, &y);
+    // Convert logical coordinates to IOFixed, scaled and rotated to the display
+    IOFixed x, y;
+    displays.getPointerTransform().apply(clampToPanel(logicalX, logicalMaxX), clampToPanel(logicalY, logicalMaxY), &x, &y);
 
     // Dispatch the actual event
-    dispatchDigitizerEventWithTiltOrientation(timestamp, 0, kDigitiserTransducerFinger, 0x1, clickType, x, y);
+    dispatchDigitizerEventWithTiltOrientation(eventTimestamp, 0, kDigitiserTransducerFinger, 0x1, clickType, x, y);
 
     // Store the coordinates so we can lift the finger later
     lastEventFixedX = x;
     lastEventFixedY = y;
 }
 
-void VoodooI2CGoodixEventDriver::scheduleLift() {
-    this->liftTimerSource->cancelTimeout();
-    this->liftTimerSource->setTimeoutMS(FINGER_LIFT_DELAY);
-}
-
 void VoodooI2CGoodixEventDriver::fingerLift() {
-    #ifdef GOODIX_EVENT_DRIVER_LIFT_DEBUG
-    IOLog("%s::Finger lifted\n", getName());
-    #endif
-
-    AbsoluteTime timestamp;
-    clock_get_uptime(&timestamp);
-
-    // Special case: dispatch a click when hover ends if the finger was never lifted after a right click
-    // This simualtes right click and drag without all the fuss
-    if (currentInteractionType == RIGHT_CLICK && movedDuringRightClick) {
-        dispatchDigitizerEvent(nextLogicalX, nextLogicalY, LEFT_CLICK);
-        dispatchDigitizerEvent(nextLogicalX, nextLogicalY, HOVER);
-
-        #ifdef GOODIX_EVENT_DRIVER_CLICK_DEBUG
-        IOLog("%s::Right click drag end special case click at %d, %d\n", getName(), nextLogicalX, nextLogicalY);
-        #endif
-    }
-    movedDuringRightClick = false;
-
-    dispatchDigitizerEventWithTiltOrientation(timestamp, 0, kDigitiserTransducerFinger, 0x1, HOVER, lastEventFixedX, lastEventFixedY);
-
-    // Mark that the finger has been lifted
-    fingerDown = false;
-    currentInteractionType = HOVER;
+    tracepoints.record(kGoodixTraceCategoryLift, kGoodixTraceFingerLift);
 
     // Reset multitouch status so we can get single finger interactions again
     isMultitouch = false;
 
-    scrollStarted = false;
+    // The next frame puts contacts down again, so it can't be coalesced with the ones before the lift
+    reportedShape = 0;
 
-    // Reset all transducers
-    for (int i = 0; i < transducers->getCount(); i++) {
-        VoodooI2CDigitiserTransducer* transducer = OSDynamicCast(VoodooI2CDigitiserTransducer, transducers->getObject(i));
+    scrollStarted = false;
 
-        transducer->tip_switch.update(0, timestamp);
+    // Reset the transducers that are touching, the stylus is only reported through digitizer events
+    contactTracker.liftAll();
+    while (touchingSlots) {
+        int slot = __builtin_ctz(touchingSlots);
+        touchingSlots &= touchingSlots - 1;
+        fingerTransducers[slot]->tip_switch.update(0, eventTimestamp);
     }
 
     VoodooI2CMultitouchEvent event;
     event.contact_count = 0;
     event.transducers = transducers;
     if (multitouch_interface) {
-        multitouch_interface->handleInterruptReport(event, timestamp);
+        multitouch_interface->handleInterruptReport(event, eventTimestamp);
     }
 }
 
@@ -119,25 +89,19 @@ void VoodooI2CGoodixEventDriver::handleSingletouchInteraction(Touch touch, bool
         UInt8 type = HOVER;
 
         if (width == 0) {
-            #ifdef GOODIX_EVENT_DRIVER_DEBUG
-            IOLog("%s::Stylus hovering at %d, %d \n", getName(), logicalX, logicalY);
-            #endif
+            tracepoints.record(kGoodixTraceCategoryGesture, kGoodixTraceStylusHover, logicalX, logicalY);
         }
         else {
             if (stylusButton1) {
                 type = RIGHT_CLICK;
-                #ifdef GOODIX_EVENT_DRIVER_DEBUG
-                IOLog("%s::Stylus right click at %d, %d \n", getName(), logicalX, logicalY);
-                #endif
+                tracepoints.record(kGoodixTraceCategoryGesture, kGoodixTraceStylusRightClick, logicalX, logicalY);
             }
             else {
                 type = LEFT_CLICK;
-                #ifdef GOODIX_EVENT_DRIVER_DEBUG
-                IOLog("%s::Stylus left click at %d, %d \n", getName(), logicalX, logicalY);
-                #endif
+                tracepoints.record(kGoodixTraceCategoryGesture, kGoodixTraceStylusLeftClick, logicalX, logicalY);
             }
 
-            scheduleLift();
+            gestureScheduler.touching();
         }
 
         dispatchPenEvent(logicalX, logicalY, width, type);
@@ -145,235 +109,310 @@ void VoodooI2CGoodixEventDriver::handleSingletouchInteraction(Touch touch, bool
         return;
     }
 
-    UInt64 nanoseconds = getNanoseconds();
+    runGestureCommands(gestureScheduler.frame(logicalX, logicalY));
+}
 
-    if (fingerDown) {
-        if (currentInteractionType == RIGHT_CLICK) {
-            // We just executed a right click, ignore other logic and let the mouse hover
-            dispatchDigitizerEvent(logicalX, logicalY, HOVER);
+void VoodooI2CGoodixEventDriver::gestureTransition(void* target, VoodooI2CGoodixGestureState from, const VoodooI2CGoodixGestureMachine& gestures) {
+    static const UInt32 categories[kGoodixGestureEventCount] = {
+        kGoodixTraceCategoryHover,  // kGoodixGestureDown
+        kGoodixTraceCategoryHover,  // kGoodixGestureStill
+        kGoodixTraceCategoryClick,  // kGoodixGestureHold
+        kGoodixTraceCategoryDrag,   // kGoodixGestureNearMove
+        kGoodixTraceCategoryDrag,   // kGoodixGestureFarMove
+        kGoodixTraceCategoryLift,   // kGoodixGestureLift
+        kGoodixTraceCategoryClick   // kGoodixGestureClickTimeout
+    };
+    VoodooI2CGoodixEventDriver* driver = (VoodooI2CGoodixEventDriver*)target;
+    VoodooI2CGoodixGestureEvent event = gestures.getLastEvent();
+    driver->tracepoints.record(categories[event], kGoodixTraceGestureTransition, from, gestures.getState(), event, gestures.getX(), gestures.getY());
+}
 
-            if (!isCloseToLastInteraction(logicalX, logicalY)) {
-                movedDuringRightClick = true;
+void VoodooI2CGoodixEventDriver::runGestureCommands(int count) {
+    const VoodooI2CGoodixGestureOutput* outputs = gestureScheduler.getOutputs();
+    for (int i = 0; i < count; i++) {
+        const VoodooI2CGoodixGestureOutput& output = outputs[i];
+        switch (output.command) {
+            case kGoodixGestureDispatch:
+                dispatchDigitizerEvent(output.x, output.y, output.button);
+                break;
+            case kGoodixGestureLiftHover:
+                dispatchDigitizerEventWithTiltOrientation(eventTimestamp, 0, kDigitiserTransducerFinger, 0x1, HOVER, lastEventFixedX, lastEventFixedY);
+                break;
+            case kGoodixGestureLifted:
+                fingerLift();
+                break;
+            default:
+                break;
+        }
+    }
+}
 
-                // Store coordinates where we're gonna click
-                nextLogicalX = logicalX;
-                nextLogicalY = logicalY;
-            }
+void VoodooI2CGoodixEventDriver::handleMultitouchInteraction(struct Touch touches[], int numTouches, int numContacts) {
+    if (numTouches == 2 && !scrollStarted) {
+        // Move the cursor to the location between the two fingers
+        dispatchDigitizerEvent((touches[0].x + touches[1].x) / 2, (touches[0].y + touches[1].y) / 2, HOVER);
+
+        scrollStarted = true;
+        tracepoints.record(kGoodixTraceCategoryGesture, kGoodixTraceBeginScroll);
+    }
+
+    tracepoints.record(kGoodixTraceCategoryGesture, kGoodixTraceMultitouch, numTouches);
 
-            #ifdef GOODIX_EVENT_DRIVER_DRAG_DEBUG
-            IOLog("%s::Dragging for right click at %d, %d\n", getName(), logicalX, logicalY);
-            #endif
+    // Send a multitouch event for scrolls, scales, etc, each contact keeps its transducer until it lifts
+    const VoodooI2CGoodixContact* contacts = contactTracker.getContacts();
+    for (int i = 0; i < numContacts; i++) {
+        const VoodooI2CGoodixContact& contact = contacts[i];
+        VoodooI2CDigitiserTransducer* transducer = fingerTransducers[contact.slot];
+        if (!transducer) {
+            continue;
         }
-        else if (logicalX == nextLogicalX && logicalY == nextLogicalY) {
-            if (currentInteractionType == DRAG) {
-                #ifdef GOODIX_EVENT_DRIVER_DEBUG
-                IOLog("%s::Still dragging at %d, %d\n", getName(), nextLogicalX, nextLogicalY);
-                #endif
-
-                // Keep on dragging
-                dispatchDigitizerEvent(logicalX, logicalY, LEFT_CLICK);
-            }
-            else {
-                #ifdef GOODIX_EVENT_DRIVER_HOVER_DEBUG
-                IOLog("%s::Still hovering at %d, %d\n", getName(), nextLogicalX, nextLogicalY);
-                #endif
-
-                // Check for a right click
-                UInt64 elapsed = (nanoseconds - fingerDownStart) / 1000000;
-                if (elapsed >= RIGHT_CLICK_DELAY) {
-                    // Cancel our outstanding click, we're right clicking now
-                    this->clickTimerSource->cancelTimeout();
-
-                    #ifdef GOODIX_EVENT_DRIVER_CLICK_DEBUG
-                    IOLog("%s::Right click at %d, %d\n", getName(), logicalX, logicalY);
-                    #endif
-
-                    dispatchDigitizerEvent(logicalX, logicalY, RIGHT_CLICK);
-                    currentInteractionType = RIGHT_CLICK;
-                    movedDuringRightClick = false;
-                }
-
-                // Hover in the same place
-                dispatchDigitizerEvent(logicalX, logicalY, HOVER);
-
-                if (currentInteractionType != RIGHT_CLICK) {
-                    // Wait a tick to begin the click check
-                    // This helps avoid phantom clicks
-                    scheduleClickCheck();
-                }
-            }
+
+        if (contact.state == kGoodixContactUp) {
+            transducer->tip_switch.update(0, eventTimestamp);
+            touchingSlots &= ~(1 << contact.slot);
+            continue;
         }
-        else {
-            if (currentInteractionType == LEFT_CLICK) {
-                // Cancel our outstanding click, we're dragging now
-                this->clickTimerSource->cancelTimeout();
 
-                #ifdef GOODIX_EVENT_DRIVER_DRAG_DEBUG
-                IOLog("%s::Begin dragging at %d, %d\n", getName(), nextLogicalX, nextLogicalY);
-                #endif
+        transducer->coordinates.x.update(contact.touch.x, eventTimestamp);
+        transducer->coordinates.y.update(contact.touch.y, eventTimestamp);
 
-                // Issue a mousedown where we were before
-                dispatchDigitizerEvent(nextLogicalX, nextLogicalY, LEFT_CLICK);
+        transducer->is_valid = true; // Todo: is this required?
+        transducer->tip_switch.update(1, eventTimestamp);
+        touchingSlots |= 1 << contact.slot;
+    }
 
-                currentInteractionType = DRAG;
-            }
+    sendMultitouchEvent();
+}
 
-            #ifdef GOODIX_EVENT_DRIVER_DRAG_DEBUG
-            IOLog("%s::Dragging at %d, %d\n", getName(), logicalX, logicalY);
-            #endif
+bool VoodooI2CGoodixEventDriver::releaseLiftedContacts(int numContacts) {
+    bool released = false;
+    const VoodooI2CGoodixContact* contacts = contactTracker.getContacts();
+    for (int i = 0; i < numContacts; i++) {
+        const VoodooI2CGoodixContact& contact = contacts[i];
+        VoodooI2CDigitiserTransducer* transducer = fingerTransducers[contact.slot];
+        if (contact.state != kGoodixContactUp || !transducer) {
+            continue;
+        }
 
-            // Report that we moved with the mousedown
-            if (currentInteractionType == RIGHT_CLICK) {
-                dispatchDigitizerEvent(logicalX, logicalY, RIGHT_CLICK);
-            }
-            else {
-                dispatchDigitizerEvent(logicalX, logicalY, LEFT_CLICK);
-            }
+        transducer->tip_switch.update(0, eventTimestamp);
+        touchingSlots &= ~(1 << contact.slot);
+        released = true;
+    }
+    return released;
+}
+
+void VoodooI2CGoodixEventDriver::sendMultitouchEvent() {
+    VoodooI2CMultitouchEvent event;
+    event.contact_count = contactTracker.getActiveCount();
+    event.transducers = transducers;
+    if (multitouch_interface) {
+        multitouch_interface->handleInterruptReport(event, eventTimestamp);
+    }
+}
+
+void VoodooI2CGoodixEventDriver::reportTouches(struct Touch touches[], int numTouches, bool stylusButton1, bool stylusButton2) {
+    // The panel sends a report without contacts when the last one lifts
+    if (numTouches == 0) {
+        runGestureCommands(gestureScheduler.liftNow());
+        return;
+    }
+
+    int numContacts = contactTracker.update(touches, numTouches);
+
+    if (numTouches == 1) {
+        // Block single touch interactions until fingers have lifted after a multitouch interaction
+        if (!isMultitouch) {
+            handleSingletouchInteraction(touches[0], stylusButton1, stylusButton2);
+        }
+        else {
+            tracepoints.record(kGoodixTraceCategoryGesture, kGoodixTracePhantomTouch);
 
-            // Store the coordinates for the next tick
-            nextLogicalX = logicalX;
-            nextLogicalY = logicalY;
+            // The fingers that lifted to get here still have to be released in the multitouch interface
+            if (releaseLiftedContacts(numContacts)) {
+                sendMultitouchEvent();
+            }
         }
     }
     else {
-        // The finger just hit the screen, so store the start time
-        fingerDownStart = nanoseconds;
-        fingerDown = true;
-        nextLogicalX = logicalX;
-        nextLogicalY = logicalY;
-        currentInteractionType = LEFT_CLICK;
+        // Cancels the outstanding click and keeps the fingers down until the gesture ends
+        gestureScheduler.multitouch();
+
+        isMultitouch = true;
+        handleMultitouchInteraction(touches, numTouches, numContacts);
+    }
+}
 
-        #ifdef GOODIX_EVENT_DRIVER_HOVER_DEBUG
-        IOLog("%s::Began hover at %d, %d\n", getName(), nextLogicalX, nextLogicalY);
-        #endif
+bool VoodooI2CGoodixEventDriver::enqueueFrame(const TouchFrame& frame) {
+    if (!frameSource) {
+        return false;
+    }
 
-        dispatchDigitizerEvent(logicalX, logicalY, HOVER);
+    if (!frames.push(frame)) {
+        droppedFrames++;
+        return false;
     }
 
-    // No matter what, we need to ensure we issue a mouseup after some time
-    scheduleLift();
+    // Wake the work loop to report it
+    frameSource->interruptOccurred(NULL, NULL, 0);
+    return true;
 }
 
-void VoodooI2CGoodixEventDriver::scheduleClickCheck() {
-    this->clickTimerSource->cancelTimeout();
-    this->clickTimerSource->setTimeoutMS(CLICK_DELAY);
+UInt32 VoodooI2CGoodixEventDriver::queuedFrames() const {
+    return frames.count();
 }
 
-bool VoodooI2CGoodixEventDriver::isCloseToLastInteraction(UInt16 x, UInt16 y) {
-    return (
-        abs(x - nextLogicalX) <= DOUBLE_CLICK_FAT_ZONE &&
-        abs(y - nextLogicalY) <= DOUBLE_CLICK_FAT_ZONE
-    );
+void VoodooI2CGoodixEventDriver::setCoalescing(bool enable) {
+    coalesceFrames = enable;
 }
 
-void VoodooI2CGoodixEventDriver::checkForClick() {
-    if (!fingerDown) {
-        // The finger was lifted within click time, which means we have a click!
-        UInt64 nanoseconds = getNanoseconds();
+void VoodooI2CGoodixEventDriver::setTraceCategories(UInt32 mask) {
+    tracepoints.setCategories(mask);
+}
 
-        UInt64 clickTimeDifference = (nanoseconds - lastClickTime) / 1000000;
+void VoodooI2CGoodixEventDriver::dumpTracepoints() {
+    tracepoints.dump(getName());
+}
 
-        if (
-            isCloseToLastInteraction(lastClickX, lastClickY) &&
-            clickTimeDifference <= DOUBLE_CLICK_TIME
-        ) {
-            nextLogicalX = lastClickX;
-            nextLogicalY = lastClickY;
+void VoodooI2CGoodixEventDriver::setClock(VoodooI2CGoodixClock* newClock) {
+    if (!newClock) {
+        newClock = &systemClock;
+    }
+    if (newClock == gestureScheduler.getClock()) {
+        return;
+    }
 
-            dispatchDigitizerEvent(nextLogicalX, nextLogicalY, LEFT_CLICK);
-            dispatchDigitizerEvent(nextLogicalX, nextLogicalY, HOVER);
+    // Times from different clocks can't be compared
+    gestureScheduler.setClock(newClock);
 
-            #ifdef GOODIX_EVENT_DRIVER_CLICK_DEBUG
-            IOLog("%s::Executing a double click at %d, %d\n", getName(), nextLogicalX, nextLogicalY);
-            #endif
-        }
-        else {
-            #ifdef GOODIX_EVENT_DRIVER_CLICK_DEBUG
-            IOLog("%s::Executing a click at %d, %d\n", getName(), nextLogicalX, nextLogicalY);
-            #endif
-        }
+    newClock->setAction(&VoodooI2CGoodixEventDriver::timerFired, this);
+}
 
-        dispatchDigitizerEvent(nextLogicalX, nextLogicalY, LEFT_CLICK);
-        dispatchDigitizerEvent(nextLogicalX, nextLogicalY, HOVER);
+void VoodooI2CGoodixEventDriver::beginReplay(UInt64 start) {
+    if (commandGate) {
+        commandGate->runAction(OSMemberFunctionCast(IOCommandGate::Action, this, &VoodooI2CGoodixEventDriver::beginReplayGated), &start);
+    }
+}
 
-        lastClickTime = nanoseconds;
-        lastClickX = nextLogicalX;
-        lastClickY = nextLogicalY;
+void VoodooI2CGoodixEventDriver::endReplay() {
+    if (commandGate) {
+        commandGate->runAction(OSMemberFunctionCast(IOCommandGate::Action, this, &VoodooI2CGoodixEventDriver::endReplayGated));
     }
 }
 
-void VoodooI2CGoodixEventDriver::handleMultitouchInteraction(struct Touch touches[], int numTouches) {
-    // Set rotation for gestures
-    multitouch_interface->setProperty(kIOFBTransformKey, currentRotation, 8);
+IOReturn VoodooI2CGoodixEventDriver::beginReplayGated(UInt64* start) {
+    // Live touches end here, the replay can't continue them
+    runGestureCommands(gestureScheduler.liftNow());
 
-    if (numTouches == 2 && !scrollStarted) {
-        // Move the cursor to the location between the two fingers
-        dispatchDigitizerEvent((touches[0].x + touches[1].x) / 2, (touches[0].y + touches[1].y) / 2, HOVER);
+    // Starts over from a clean state even if the last replay never ended
+    setClock(NULL);
+    replayClock.reset(*start);
+    setClock(&replayClock);
 
-        scrollStarted = true;
-        #ifdef GOODIX_EVENT_DRIVER_DEBUG
-        IOLog("%s::Starting scroll\n", getName());
-        #endif
+    // Replayed events are dispatched as if the trace started now, this wraps if it was recorded after a longer uptime
+    dispatchOffset = systemClock.getNanoseconds() - *start;
+    return kIOReturnSuccess;
+}
+
+IOReturn VoodooI2CGoodixEventDriver::endReplayGated() {
+    if (gestureScheduler.getClock() == &replayClock) {
+        replayClock.advance(REPLAY_SETTLE_DELAY * 1000000ULL);
+        setClock(NULL);
+        dispatchOffset = 0;
     }
+    return kIOReturnSuccess;
+}
 
-    #ifdef GOODIX_EVENT_DRIVER_DEBUG
-    IOLog("%s::Handling multitouch with %d fingers\n", getName(), numTouches);
-    #endif
+void VoodooI2CGoodixEventDriver::timerFired(void* target, VoodooI2CGoodixTimerID timer) {
+    VoodooI2CGoodixEventDriver* driver = (VoodooI2CGoodixEventDriver*)target;
+    int count = driver->gestureScheduler.timerFired(timer);
+    driver->setEventTimestamp(driver->gestureScheduler.getEventNanoseconds());
+    driver->runGestureCommands(count);
+}
+
+void VoodooI2CGoodixEventDriver::setEventTimestamp(UInt64 nanoseconds) {
+    nanoseconds += dispatchOffset;
+    if (nanoseconds < eventNanoseconds) {
+        return;
+    }
+    eventNanoseconds = nanoseconds;
+    nanoseconds_to_absolutetime(nanoseconds, &eventTimestamp);
+}
+
+// Everything about a frame except where its contacts are, frames with the same shape only move contacts
+static UInt32 getFrameShape(const TouchFrame& frame) {
+    UInt32 shape = frame.numTouches << 16 | frame.stylusButton1 << 24 | frame.stylusButton2 << 25;
+    for (int i = 0; i < frame.numTouches; i++) {
+        shape |= 1 << frame.touches[i].id;
+        if (frame.touches[i].type) {
+            shape |= frame.touches[i].width ? 1 << 27 : 1 << 26;
+        }
+    }
+    return shape;
+}
 
-    AbsoluteTime timestamp;
-    clock_get_uptime(&timestamp);
+void VoodooI2CGoodixEventDriver::processFrames(OSObject* owner, IOInterruptEventSource* src, int intCount) {
+    TouchFrame frame;
+    while (frames.pop(frame)) {
+        UInt32 shape = getFrameShape(frame);
+        const TouchFrame* next;
+        if (coalesceFrames && shape == reportedShape && (next = frames.peek()) && getFrameShape(*next) == shape) {
+            coalescedFrames++;
+            continue;
+        }
+        reportedShape = shape;
 
-    // Send a multitouch event for scrolls, scales, etc
-    for (int i = 0; i < numTouches; i++) {
-        Touch touch = touches[i];
+        // Replayed frames move the replay clock, firing the timers that would have fired before them
+        VoodooI2CGoodixClock* clock = gestureScheduler.getClock();
+        if (!frame.readTimestamp && clock == &replayClock) {
+            replayClock.advanceTo(frame.timestamp);
+        }
 
-        VoodooI2CDigitiserTransducer* transducer = OSDynamicCast(VoodooI2CDigitiserTransducer, transducers->getObject(i));
-        transducer->coordinates.x.update(touch.x, timestamp);
-        transducer->coordinates.y.update(touch.y, timestamp);
+        UInt64 start = systemClock.getNanoseconds();
 
-        transducer->is_valid = true; // Todo: is this required?
-        transducer->tip_switch.update(1, timestamp);
-    }
+        // Every event of the frame carries the time the panel signalled it, not the time it's dispatched
+        gestureScheduler.setEventTime(frame.timestamp);
+        setEventTimestamp(frame.timestamp);
+        reportTouches(frame.touches, frame.numTouches, frame.stylusButton1, frame.stylusButton2);
 
-    VoodooI2CMultitouchEvent event;
-    event.contact_count = numTouches;
-    event.transducers = transducers;
-    if (multitouch_interface) {
-        multitouch_interface->handleInterruptReport(event, timestamp);
+        // Replayed frames were never read from the panel
+        if (frame.readTimestamp) {
+            UInt64 end = systemClock.getNanoseconds();
+            queueLatency.record((start - frame.readTimestamp) / 1000);
+            dispatchLatency.record((end - start) / 1000);
+            totalLatency.record((end - frame.timestamp) / 1000);
+        }
     }
+}
 
-    // Make sure we schedule a lift for when the gesture ends to reset state
-    scheduleLift();
+bool VoodooI2CGoodixEventDriver::serializeProperties(OSSerialize* s) const {
+    const_cast<VoodooI2CGoodixEventDriver*>(this)->publishStatistics();
+    return super::serializeProperties(s);
 }
 
-void VoodooI2CGoodixEventDriver::reportTouches(struct Touch touches[], int numTouches, bool stylusButton1, bool stylusButton2) {
-    if (!activeFramebuffer) {
-        activeFramebuffer = getFramebuffer();
+void VoodooI2CGoodixEventDriver::publishStatistics() {
+    OSDictionary* statistics = OSDictionary::withCapacity(1);
+    if (!statistics) {
+        return;
     }
 
-    if (activeFramebuffer) {
-        OSNumber* number = OSDynamicCast(OSNumber, activeFramebuffer->getProperty(kIOFBTransformKey));
-        currentRotation = number->unsigned8BitValue() / 0x10;
+    OSNumber* number = OSNumber::withNumber(droppedFrames, 64);
+    if (number) {
+        statistics->setObject("Dropped Frames", number);
+        number->release();
     }
 
-    if (numTouches == 1) {
-        // Block single touch interactions until fingers have lifted after a multitouch interaction
-        if (!isMultitouch) {
-            handleSingletouchInteraction(touches[0], stylusButton1, stylusButton2);
-        }
-        else {
-            #ifdef GOODIX_EVENT_DRIVER_DEBUG
-            IOLog("%s::Blocking phantom single touch interaction\n", getName());
-            #endif
-        }
+    number = OSNumber::withNumber(coalescedFrames, 64);
+    if (number) {
+        statistics->setObject("Coalesced Frames", number);
+        number->release();
     }
-    else {
-        // Cancel our outstanding click, we're multitouching
-        this->clickTimerSource->cancelTimeout();
 
-        isMultitouch = true;
-        handleMultitouchInteraction(touches, numTouches);
-    }
+    queueLatency.publish(statistics, "Queue Latency");
+    dispatchLatency.publish(statistics, "Dispatch Latency");
+    totalLatency.publish(statistics, "Total Latency");
+
+    setProperty("Statistics", statistics);
+    statistics->release();
 }
 
 bool VoodooI2CGoodixEventDriver::handleStart(IOService* provider) {
@@ -393,27 +432,59 @@ bool VoodooI2CGoodixEventDriver::handleStart(IOService* provider) {
     publishMultitouchInterface();
 
     multitouch_interface->registerService();
+    multitouch_interface->setProperty(kIOFBTransformKey, publishedRotation, 8);
 
-    activeFramebuffer = getFramebuffer();
+    gestureScheduler.setClock(&systemClock);
+    gestureScheduler.setObserver(&VoodooI2CGoodixEventDriver::gestureTransition, this);
+    systemClock.setAction(&VoodooI2CGoodixEventDriver::timerFired, this);
+    if (!systemClock.start(this, work_loop)) {
+        IOLog("%s::Could not add timer source to work loop\n", getName());
+        return false;
+    }
 
-    liftTimerSource = IOTimerEventSource::timerEventSource(this, OSMemberFunctionCast(IOTimerEventSource::Action, this, &VoodooI2CGoodixEventDriver::fingerLift));
-    if (!liftTimerSource || work_loop->addEventSource(liftTimerSource) != kIOReturnSuccess) {
-        IOLog("%s::Could not add lift timer source to work loop\n", getName());
+    // Signalled by the touch driver whenever it queues a frame
+    frameSource = IOInterruptEventSource::interruptEventSource(this, OSMemberFunctionCast(IOInterruptEventAction, this, &VoodooI2CGoodixEventDriver::processFrames));
+    if (!frameSource || work_loop->addEventSource(frameSource) != kIOReturnSuccess) {
+        IOLog("%s::Could not add frame source to work loop\n", getName());
         return false;
     }
+    frameSource->enable();
 
-    clickTimerSource = IOTimerEventSource::timerEventSource(this, OSMemberFunctionCast(IOTimerEventSource::Action, this, &VoodooI2CGoodixEventDriver::checkForClick));
-    if (!clickTimerSource || work_loop->addEventSource(clickTimerSource) != kIOReturnSuccess) {
-        IOLog("%s::Could not add click timer source to work loop\n", getName());
+    // Rotation only changes with the display's mode, so it's cached instead of read on every frame
+    commandGate = IOCommandGate::commandGate(this);
+    if (!commandGate || work_loop->addEventSource(commandGate) != kIOReturnSuccess) {
+        IOLog("%s::Could not add command gate to work loop\n", getName());
         return false;
     }
 
+    framebufferNotifier = IOFramebuffer::addFramebufferNotification(OSMemberFunctionCast(IOFramebufferNotificationHandler, this, &VoodooI2CGoodixEventDriver::framebufferChanged), this, NULL);
+
+    // The touchscreen follows the display with the IDs it's configured with, or else the internal panel
+    OSNumber* vendorID = OSDynamicCast(OSNumber, provider->getProperty("DisplayVendorID"));
+    OSNumber* productID = OSDynamicCast(OSNumber, provider->getProperty("DisplayProductID"));
+    displays.setPreferred(vendorID ? vendorID->unsigned32BitValue() : 0, productID ? productID->unsigned32BitValue() : 0);
+
+    OSBoolean* coalesce = OSDynamicCast(OSBoolean, provider->getProperty("CoalesceFrames"));
+    coalesceFrames = !coalesce || coalesce->isTrue();
+
+    OSDictionary* match = serviceMatching("IODisplay");
+    if (match) {
+        displayNotifier = addMatchingNotification(gIOMatchedNotification, match, OSMemberFunctionCast(IOServiceMatchingNotificationHandler, this, &VoodooI2CGoodixEventDriver::displayMatched), this);
+        displayTerminatedNotifier = addMatchingNotification(gIOTerminatedNotification, match, OSMemberFunctionCast(IOServiceMatchingNotificationHandler, this, &VoodooI2CGoodixEventDriver::displayTerminated), this);
+        match->release();
+    }
+    if (!framebufferNotifier || !displayNotifier || !displayTerminatedNotifier) {
+        IOLog("%s::Could not watch displays, touches won't follow rotation\n", getName());
+    }
+
     return true;
 }
 
 void VoodooI2CGoodixEventDriver::handleStop(IOService* provider) {
     unpublishMultitouchInterface();
 
+    memset(fingerTransducers, 0, sizeof(fingerTransducers));
+    touchingSlots = 0;
     if (transducers) {
         for (int i = 0; i < transducers->getCount(); i++) {
             OSObject* object = transducers->getObject(i);
@@ -424,21 +495,38 @@ void VoodooI2CGoodixEventDriver::handleStop(IOService* provider) {
         OSSafeReleaseNULL(transducers);
     }
 
-    if (liftTimerSource) {
-        liftTimerSource->cancelTimeout();
-        work_loop->removeEventSource(liftTimerSource);
-        OSSafeReleaseNULL(liftTimerSource);
+    if (displayNotifier) {
+        displayNotifier->remove();
+        displayNotifier = NULL;
+    }
+
+    if (displayTerminatedNotifier) {
+        displayTerminatedNotifier->remove();
+        displayTerminatedNotifier = NULL;
     }
 
-    if (clickTimerSource) {
-        clickTimerSource->cancelTimeout();
-        work_loop->removeEventSource(clickTimerSource);
-        OSSafeReleaseNULL(clickTimerSource);
+    if (framebufferNotifier) {
+        framebufferNotifier->remove();
+        framebufferNotifier = NULL;
+    }
+
+    if (commandGate) {
+        work_loop->removeEventSource(commandGate);
+        OSSafeReleaseNULL(commandGate);
+    }
+
+    gestureScheduler.setClock(&systemClock);
+    systemClock.stop();
+
+    if (frameSource) {
+        frameSource->disable();
+        work_loop->removeEventSource(frameSource);
+        OSSafeReleaseNULL(frameSource);
     }
 
     OSSafeReleaseNULL(work_loop);
 
-//    OSSafeReleaseNULL(activeFramebuffer); // Todo: do we need to do this?
+    displays.removeAll();
 
     super::handleStop(provider);
 }
@@ -479,6 +567,10 @@ void VoodooI2CGoodixEventDriver::configureMultitouchInterface(int logicalMaxX, i
         multitouch_interface->logical_max_x = logicalMaxX;
         multitouch_interface->logical_max_y = logicalMaxY;
 
+        if (commandGate) {
+            commandGate->runAction(OSMemberFunctionCast(IOCommandGate::Action, this, &VoodooI2CGoodixEventDriver::setLogicalSize), &logicalMaxX, &logicalMaxY);
+        }
+
         multitouch_interface->setProperty(kIOHIDVendorIDKey, vendorId, 32);
         multitouch_interface->setProperty(kIOHIDProductIDKey, vendorId, 32);
 
@@ -502,6 +594,9 @@ void VoodooI2CGoodixEventDriver::configureMultitouchInterface(int logicalMaxX, i
             transducer->secondary_id = i;
 
             transducers->setObject(transducer);
+            if (i < GOODIX_MAX_CONTACTS) {
+                fingerTransducers[i] = transducer;
+            }
         }
 
         // Set up an additional transducer as the stylus
@@ -549,48 +644,90 @@ bool VoodooI2CGoodixEventDriver::start(IOService* provider) {
     return true;
 }
 
-IOFramebuffer* VoodooI2CGoodixEventDriver::getFramebuffer() {
-    IORegistryEntry* display = NULL;
-    IOFramebuffer* framebuffer = NULL;
+IOFramebuffer* VoodooI2CGoodixEventDriver::getFramebuffer(IOService* display) {
+    IORegistryEntry* entry = display->getParentEntry(gIOServicePlane);
+    if (entry) {
+        entry = entry->getParentEntry(gIOServicePlane);
+    }
+    if (!entry) {
+        return NULL;
+    }
+    return reinterpret_cast<IOFramebuffer*>(entry->metaCast("IOFramebuffer"));
+}
 
-    OSDictionary *match = serviceMatching("IODisplay");
-    OSIterator *iterator = getMatchingServices(match);
+bool VoodooI2CGoodixEventDriver::displayMatched(void* refCon, IOService* display, IONotifier* notifier) {
+    if (commandGate) {
+        commandGate->runAction(OSMemberFunctionCast(IOCommandGate::Action, this, &VoodooI2CGoodixEventDriver::addDisplay), display);
+    }
+    return true;
+}
 
-    if (iterator) {
-        display = OSDynamicCast(IORegistryEntry, iterator->getNextObject());
+bool VoodooI2CGoodixEventDriver::displayTerminated(void* refCon, IOService* display, IONotifier* notifier) {
+    if (commandGate) {
+        commandGate->runAction(OSMemberFunctionCast(IOCommandGate::Action, this, &VoodooI2CGoodixEventDriver::removeDisplay), display);
+    }
+    return true;
+}
 
-        if (display) {
-            IOLog("%s::Got active display\n", getName());
+IOReturn VoodooI2CGoodixEventDriver::framebufferChanged(void* ref, IOFramebuffer* framebuffer, IOIndex event, void* info) {
+    // Rotating the display changes its mode
+    if (event == kIOFBNotifyDisplayModeDidChange && commandGate) {
+        commandGate->runAction(OSMemberFunctionCast(IOCommandGate::Action, this, &VoodooI2CGoodixEventDriver::updateRotation), framebuffer);
+    }
+    return kIOReturnSuccess;
+}
 
-            IORegistryEntry *entry = display->getParentEntry(gIOServicePlane)->getParentEntry(gIOServicePlane);
-            if (entry)
-                framebuffer = reinterpret_cast<IOFramebuffer*>(entry->metaCast("IOFramebuffer"));
+IOReturn VoodooI2CGoodixEventDriver::addDisplay(IOService* display) {
+    IOFramebuffer* framebuffer = getFramebuffer(display);
+    if (!framebuffer) {
+        return kIOReturnNotFound;
+    }
 
-            if (framebuffer) {
-                IOLog("%s::Got active framebuffer\n", getName());
-            }
+    if (displays.add(display, framebuffer)) {
+        const VoodooI2CGoodixDisplay* active = displays.getActive();
+        IOLog("%s::Following display %x:%x%s\n", getName(), active->vendorID, active->productID, active->internal ? " (internal)" : "");
+        publishRotation();
+    }
+    return kIOReturnSuccess;
+}
+
+IOReturn VoodooI2CGoodixEventDriver::removeDisplay(IOService* display) {
+    if (displays.remove(display)) {
+        const VoodooI2CGoodixDisplay* active = displays.getActive();
+        if (active) {
+            IOLog("%s::Display disconnected, following display %x:%x\n", getName(), active->vendorID, active->productID);
+        }
+        else {
+            IOLog("%s::Display disconnected, no display left to follow\n", getName());
         }
+        publishRotation();
+    }
+    return kIOReturnSuccess;
+}
 
-        OSSafeReleaseNULL(iterator);
+IOReturn VoodooI2CGoodixEventDriver::updateRotation(IOFramebuffer* framebuffer) {
+    if (displays.updateRotation(framebuffer)) {
+        publishRotation();
     }
+    return kIOReturnSuccess;
+}
 
-    OSSafeReleaseNULL(match);
+void VoodooI2CGoodixEventDriver::publishRotation() {
+    UInt8 rotation = displays.getRotation();
+    if (rotation == publishedRotation) {
+        return;
+    }
+    publishedRotation = rotation;
 
-    return framebuffer;
+    // Set rotation for gestures
+    if (multitouch_interface) {
+        multitouch_interface->setProperty(kIOFBTransformKey, rotation, 8);
+    }
 }
 
-void VoodooI2CGoodixEventDriver::checkRotation(IOFixed* x, IOFixed* y) {
-    if (activeFramebuffer) {
-        if (currentRotation & kIOFBSwapAxes) {
-            IOFixed old_x = *x;
-            *x = *y;
-            *y = old_x;
-        }
-        if (currentRotation & kIOFBInvertX) {
-            *x = 65535 - *x;
-        }
-        if (currentRotation & kIOFBInvertY) {
-            *y = 65535 - *y;
-        }
-    }
+IOReturn VoodooI2CGoodixEventDriver::setLogicalSize(int* newLogicalMaxX, int* newLogicalMaxY) {
+    logicalMaxX = *newLogicalMaxX;
+    logicalMaxY = *newLogicalMaxY;
+    displays.setLogicalSize(logicalMaxX, logicalMaxY);
+    return kIOReturnSuccess;
 }
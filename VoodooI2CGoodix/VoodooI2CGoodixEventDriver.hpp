@@ -20,6 +20,8 @@
 #include <IOKit/IOService.h>
 #include <IOKit/IOWorkLoop.h>
 #include <IOKit/IOTimerEventSource.h>
+#include <IOKit/IOInterruptEventSource.h>
+#include <IOKit/IOCommandGate.h>
 
 #include <IOKit/hidevent/IOHIDEventService.h>
 #include <IOKit/hidsystem/IOHIDTypes.h>
@@ -33,28 +35,21 @@
 
 #include "../../../Dependencies/helpers.hpp"
 
-#define FINGER_LIFT_DELAY   50
-#define CLICK_DELAY         100
-#define RIGHT_CLICK_DELAY   500
+#include "./VoodooI2CGoodixClock.hpp"
+#include "./VoodooI2CGoodixContactTracker.hpp"
+#include "./VoodooI2CGoodixDisplays.hpp"
+#include "./VoodooI2CGoodixFrameRing.hpp"
+#include "./VoodooI2CGoodixGestureScheduler.hpp"
+#include "./VoodooI2CGoodixLatencyHistogram.hpp"
+#include "./VoodooI2CGoodixReport.hpp"
+#include "./VoodooI2CGoodixTracepoints.hpp"
+#include "./VoodooI2CGoodixTransform.hpp"
+#include "goodix.h"
+
+#define REPLAY_SETTLE_DELAY (FINGER_LIFT_DELAY + CLICK_DELAY) // lets the timers armed by the last replayed frame fire
 #define HOVER       0x0
 #define LEFT_CLICK  0x1
 #define RIGHT_CLICK 0x2
-#define DRAG        0x5
-#define DOUBLE_CLICK_FAT_ZONE   40
-#define DOUBLE_CLICK_TIME       450
-
-//#define GOODIX_EVENT_DRIVER_CLICK_DEBUG
-//#define GOODIX_EVENT_DRIVER_LIFT_DEBUG
-//#define GOODIX_EVENT_DRIVER_HOVER_DEBUG
-//#define GOODIX_EVENT_DRIVER_DRAG_DEBUG
-//#define GOODIX_EVENT_DRIVER_DEBUG
-
-struct Touch {
-    int x;
-    int y;
-    int width;
-    bool type; // 0 = finger, 1 = pen
-};
 
 /* Implements an HID Event Driver for HID devices that expose a digitiser usage page.
  *
@@ -111,6 +106,66 @@ class EXPORT VoodooI2CGoodixEventDriver : public IOHIDEventService {
 
     void reportTouches(struct Touch touches[], int numTouches, bool stylusButton1, bool stylusButton2);
 
+    /* Queue a frame to be reported on the work loop, called from the touch driver's reader thread
+     * @frame The frame of touches
+     *
+     * @return false if the queue was full and the frame was dropped
+     */
+
+    bool enqueueFrame(const TouchFrame& frame);
+
+    /* The number of frames waiting to be reported
+     */
+
+    UInt32 queuedFrames() const;
+
+    /* Set whether frames that only move contacts are skipped when a newer one is already queued
+     * @enable true to report only the latest position while dispatch is behind the panel
+     */
+
+    void setCoalescing(bool enable);
+
+    /* Enable tracepoints by category
+     * @mask The kGoodixTraceCategory* categories to enable
+     */
+
+    void setTraceCategories(UInt32 mask);
+
+    /* Log the most recent tracepoints
+     */
+
+    void dumpTracepoints();
+
+    /* Read time and arm timers through another clock, e.g. a <VoodooI2CGoodixVirtualClock> to replay frames in simulated time
+     * @newClock The clock to use, or NULL to go back to uptime and the work loop's timers
+     *
+     * Must be called on the work loop, timers armed on the previous clock are cancelled
+     */
+
+    void setClock(VoodooI2CGoodixClock* newClock);
+
+    /* Report replayed frames in the time they were recorded in, called from the touch driver's reader thread
+     * @start The timestamp of the first replayed frame
+     *
+     * Anything in progress is lifted, and frames without a read timestamp move <replayClock> to their
+     * timestamp, firing the timers they pass, until <endReplay>. Frames queued before must be reported first.
+     * Their events are dispatched at the uptime the replay began at plus their time since <start>.
+     */
+
+    void beginReplay(UInt64 start);
+
+    /* Fire the timers the replayed frames left armed and go back to uptime, called from the touch driver's reader thread
+     *
+     * The replayed frames must all be reported first.
+     */
+
+    void endReplay();
+
+    /* Refreshes the published statistics before the registry is read
+     */
+
+    bool serializeProperties(OSSerialize* s) const override;
+
     /* Initialize the multitouch interface with the provided logical size
      * @logicalMaxX The logical max X coordinate in pixels
      * @logicalMaxY The logical max Y coordinate in pixels
@@ -160,80 +215,189 @@ class EXPORT VoodooI2CGoodixEventDriver : public IOHIDEventService {
 
     void dispatchPenEvent(int logicalX, int logicalY, int pressure, UInt32 clickType);
 
-    /* Check if this interaction is within fat finger distance
+    /* Execute the commands the gesture scheduler produced
+     * @count The number of commands
+     */
+
+    void runGestureCommands(int count);
+
+    /* Record a tracepoint for a gesture machine transition, called by the gesture scheduler
      */
-    bool isCloseToLastInteraction(UInt16 x, UInt16 y);
 
-    /* Dispatch a finger lift event at the location of the last digitizer event
+    static void gestureTransition(void* target, VoodooI2CGoodixGestureState from, const VoodooI2CGoodixGestureMachine& gestures);
+
+    /* Reset the transducers and multitouch state once the gesture scheduler lifted the fingers
      */
 
     void fingerLift();
 
-    /* Schedule a finger lift event
+    /* Called by the clock when one of the timers fires
+     */
+
+    static void timerFired(void* target, VoodooI2CGoodixTimerID timer);
+
+    /* Get the framebuffer a display is attached to
+     * @display The IODisplay
+     */
+
+    IOFramebuffer* getFramebuffer(IOService* display);
+
+    /* Called when an IODisplay is published
+     */
+
+    bool displayMatched(void* refCon, IOService* display, IONotifier* notifier);
+
+    /* Called when an IODisplay is terminated
+     */
+
+    bool displayTerminated(void* refCon, IOService* display, IONotifier* notifier);
+
+    /* Called when the state of any framebuffer changes
+     */
+
+    IOReturn framebufferChanged(void* ref, IOFramebuffer* framebuffer, IOIndex event, void* info);
+
+    /* Start following a display that was connected, called through the command gate
+     */
+
+    IOReturn addDisplay(IOService* display);
+
+    /* Stop following a display that was disconnected, called through the command gate
+     */
+
+    IOReturn removeDisplay(IOService* display);
+
+    /* Read the rotation of a framebuffer whose mode changed, called through the command gate
+     */
+
+    IOReturn updateRotation(IOFramebuffer* framebuffer);
+
+    /* Set the panel's logical size and rebuild the pointer transforms, called through the command gate
+     * @newLogicalMaxX The logical max X coordinate
+     * @newLogicalMaxY The logical max Y coordinate
+     */
+
+    IOReturn setLogicalSize(int* newLogicalMaxX, int* newLogicalMaxY);
+
+    /* Switches to <replayClock> at the replay's start time, on the work loop
+     * @start The timestamp of the first replayed frame
+     */
+
+    IOReturn beginReplayGated(UInt64* start);
+
+    /* Settles <replayClock> and switches back to uptime, on the work loop
      */
 
-    void scheduleLift();
+    IOReturn endReplayGated();
 
-    /* Get the active framebuffer
+    /* Tell the multitouch interface about the active display's rotation if it changed
      */
-    IOFramebuffer* getFramebuffer();
 
-    /* Rotate coordinates to match current framebuffer's rotation
+    void publishRotation();
+
+    /* Set the time that the events dispatched from now on carry
+     * @nanoseconds The time on the gesture scheduler's clock, which is moved to uptime by <dispatchOffset>.
+     *  Events never go back in time, so a time before the last event's is ignored
+     */
+
+    void setEventTimestamp(UInt64 nanoseconds);
+
+    /* Report every queued frame, runs on the work loop
      *
-     * @x A pointer to the X coordinate
-     * @y A pointer to the Y coordinate
+     * With coalescing on, a frame is skipped if it and the frame queued after it have the same
+     * contacts, stylus state and buttons as the last frame reported, so the cursor catches up to
+     * the latest position at once while every down, up and button change is still reported.
      */
 
-    void checkRotation(IOFixed* x, IOFixed* y);
+    void processFrames(OSObject* owner, IOInterruptEventSource* src, int intCount);
+
+    /* Publish event driver statistics as the "Statistics" property
+     */
+
+    void publishStatistics();
 
     /* Handle multitouch interactions
      *
      * @touches An array of Touch objects
      * @numTouches The number of touches
+     * @numContacts The number of transitions the contact tracker produced for this frame
      */
-    void handleMultitouchInteraction(struct Touch touches[], int numTouches);
+    void handleMultitouchInteraction(struct Touch touches[], int numTouches, int numContacts);
 
-    /* Handle singletouch interactions
+    /* Lift the transducers of the contacts that went up in this frame, without moving the others
+     * @numContacts The number of transitions the contact tracker produced for this frame
      *
-     * @touch A single Touch object
+     * @return true if any transducer was lifted
      */
-    void handleSingletouchInteraction(Touch touch, bool stylusButton1, bool stylusButton2);
+    bool releaseLiftedContacts(int numContacts);
 
-    /* Schedule a check for a click
+    /* Send the finger transducers' state to the multitouch interface
      */
+    void sendMultitouchEvent();
 
-    void scheduleClickCheck();
-
-    /* Dispatch a click if we're supposed to
+    /* Handle singletouch interactions
+     *
+     * @touch A single Touch object
      */
-    void checkForClick();
+    void handleSingletouchInteraction(Touch touch, bool stylusButton1, bool stylusButton2);
 
 private:
     IOWorkLoop *work_loop;
-    IOTimerEventSource *liftTimerSource;
-    IOTimerEventSource *clickTimerSource;
-    IOFramebuffer* activeFramebuffer = NULL;
+    VoodooI2CGoodixSystemClock systemClock;
+    VoodooI2CGoodixVirtualClock replayClock;
+    IOInterruptEventSource *frameSource;
+    VoodooI2CGoodixFrameRing<TouchFrame, GOODIX_FRAME_RING_SIZE> frames;
+    UInt64 droppedFrames = 0;
+
+    // Whether move-only frames are coalesced, how many were skipped, and the shape of the last frame reported
+    bool coalesceFrames = true;
+    UInt64 coalescedFrames = 0;
+    UInt32 reportedShape = 0;
+
+    // Time from the report being read to reportTouches, spent in reportTouches, and from the panel's interrupt to the end of reportTouches
+    VoodooI2CGoodixLatencyHistogram<GOODIX_STAGE_BUCKETS, GOODIX_STAGE_BUCKET_WIDTH> queueLatency;
+    VoodooI2CGoodixLatencyHistogram<GOODIX_STAGE_BUCKETS, GOODIX_STAGE_BUCKET_WIDTH_FINE> dispatchLatency;
+    VoodooI2CGoodixLatencyHistogram<GOODIX_STAGE_BUCKETS, GOODIX_STAGE_BUCKET_WIDTH_COARSE> totalLatency;
 
-    UInt8 currentRotation;
+    VoodooI2CGoodixTracepoints tracepoints;
+
+    // When the panel signalled the frame being reported, or when the timer being handled fired, in uptime.
+    // It only ever moves forward, across replays too, so HID never sees time go backwards
+    UInt64 eventNanoseconds = 0;
+    AbsoluteTime eventTimestamp;
+
+    // Added to the gesture clock's time to get uptime, the uptime a replay began at less the trace's start
+    UInt64 dispatchOffset = 0;
+
+    IOCommandGate* commandGate = NULL;
+    IONotifier* displayNotifier = NULL;
+    IONotifier* framebufferNotifier = NULL;
+    IONotifier* displayTerminatedNotifier = NULL;
+
+    // Every connected display, and the rotation the multitouch interface was last told about
+    VoodooI2CGoodixDisplays displays;
+    UInt8 publishedRotation = 0;
 
     IOFixed lastEventFixedX = 0;
     IOFixed lastEventFixedY = 0;
 
-    UInt16 nextLogicalX = 0;
-    UInt16 nextLogicalY = 0;
+    // The panel's logical size
+    int logicalMaxX = 0;
+    int logicalMaxY = 0;
 
-    UInt16 lastClickX = 0;
-    UInt16 lastClickY = 0;
-    UInt64 lastClickTime = 0;
+    // Single finger clicks, drags and right clicks, and the timers of every gesture, on the clock in use
+    VoodooI2CGoodixGestureScheduler gestureScheduler;
 
-    UInt8 currentInteractionType = LEFT_CLICK;
-    bool fingerDown = false;
     bool isMultitouch = false;
-    bool movedDuringRightClick = false;
-    UInt64 fingerDownStart = 0;
 
     UInt8 stylusTransducerID;
 
+    // Contacts by slot, the transducer for each slot so frames don't have to look them up in the array,
+    // and the slots whose transducer has its tip switch down, which are the only ones a lift resets
+    VoodooI2CGoodixContactTracker contactTracker;
+    VoodooI2CDigitiserTransducer* fingerTransducers[GOODIX_MAX_CONTACTS] = {};
+    UInt16 touchingSlots = 0;
+
     bool scrollStarted = false;
 };
 
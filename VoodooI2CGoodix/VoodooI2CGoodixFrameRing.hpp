@@ -0,0 +1,89 @@
+//
+//  VoodooI2CGoodixFrameRing.hpp
+//  VoodooI2CGoodix
+//
+//  Created by agent on 10/17/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef VoodooI2CGoodixFrameRing_hpp
+#define VoodooI2CGoodixFrameRing_hpp
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* A fixed-size, lock-free queue with exactly one producer and one consumer
+ *
+ * The producer only writes head and the consumer only writes tail, so neither side ever blocks
+ * the other. Nothing is allocated after construction.
+ */
+
+template <typename T, uint32_t Size>
+class VoodooI2CGoodixFrameRing {
+    static_assert(Size && (Size & (Size - 1)) == 0, "Size must be a power of two");
+
+ public:
+    VoodooI2CGoodixFrameRing() : head(0), tail(0) {}
+
+    /* Add an item to the queue, called by the producer only
+     * @item The item to copy into the queue
+     *
+     * @return false if the queue was full and the item was not added
+     */
+
+    bool push(const T& item) {
+        uint32_t currentHead = __atomic_load_n(&head, __ATOMIC_RELAXED);
+        if (currentHead - __atomic_load_n(&tail, __ATOMIC_ACQUIRE) == Size) {
+            return false;
+        }
+
+        slots[currentHead & (Size - 1)] = item;
+        __atomic_store_n(&head, currentHead + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    /* Remove the oldest item from the queue, called by the consumer only
+     * @item Receives a copy of the item
+     *
+     * @return false if the queue was empty
+     */
+
+    bool pop(T& item) {
+        uint32_t currentTail = __atomic_load_n(&tail, __ATOMIC_RELAXED);
+        if (__atomic_load_n(&head, __ATOMIC_ACQUIRE) == currentTail) {
+            return false;
+        }
+
+        item = slots[currentTail & (Size - 1)];
+        __atomic_store_n(&tail, currentTail + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    /* Look at the oldest item without removing it, called by the consumer only
+     *
+     * @return the item, which stays valid until it's popped, or NULL if the queue was empty
+     */
+
+    const T* peek() const {
+        uint32_t currentTail = __atomic_load_n(&tail, __ATOMIC_RELAXED);
+        if (__atomic_load_n(&head, __ATOMIC_ACQUIRE) == currentTail) {
+            return NULL;
+        }
+
+        return &slots[currentTail & (Size - 1)];
+    }
+
+    /* The number of items waiting in the queue
+     */
+
+    uint32_t count() const {
+        return __atomic_load_n(&head, __ATOMIC_ACQUIRE) - __atomic_load_n(&tail, __ATOMIC_ACQUIRE);
+    }
+
+ private:
+    T slots[Size];
+    uint32_t head;
+    uint32_t tail;
+};
+
+#endif /* VoodooI2CGoodixFrameRing_hpp */
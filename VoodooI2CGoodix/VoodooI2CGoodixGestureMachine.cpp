@@ -0,0 +1,176 @@
+//
+//  VoodooI2CGoodixGestureMachine.cpp
+//  VoodooI2CGoodix
+//
+//  Created by agent on 10/17/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include "VoodooI2CGoodixGestureMachine.hpp"
+
+/* Actions, run in the order they're declared */
+enum {
+    CANCEL_CLICK    = 1 << 0,   // stop the click timer
+    CANCEL_HOLD     = 1 << 1,   // stop the hold timer
+    SET_ORIGIN      = 1 << 2,   // remember where and when the finger went down
+    LEFT_AT_NEXT    = 1 << 3,   // press the left button where the finger was
+    RIGHT_AT_POS    = 1 << 4,   // press the right button where the finger is
+    LEFT_AT_POS     = 1 << 5,   // press the left button where the finger is
+    HOVER_AT_POS    = 1 << 6,   // release the buttons where the finger is
+    UPDATE_NEXT     = 1 << 7,   // remember where the finger is
+    ARM_CLICK       = 1 << 8,   // (re)start the click timer
+    ARM_HOLD        = 1 << 9,   // start the hold timer
+    RELEASE_AT_NEXT = 1 << 10,  // click where the finger was
+    HOVER_AT_LAST   = 1 << 11,  // release the buttons where the last event was
+    CLICK           = 1 << 12   // click, or double click if close to the last click
+};
+
+struct Transition {
+    uint8_t next;
+    uint16_t actions;
+};
+
+static const Transition transitions[kGoodixGestureStateCount][kGoodixGestureEventCount] = {
+    // kGoodixGestureIdle
+    {
+        /* Down */          {kGoodixGesturePressed, SET_ORIGIN | HOVER_AT_POS | ARM_HOLD},
+        /* Still */         {kGoodixGestureIdle, 0},
+        /* Hold */          {kGoodixGestureIdle, 0},
+        /* NearMove */      {kGoodixGestureIdle, 0},
+        /* FarMove */       {kGoodixGestureIdle, 0},
+        /* Lift */          {kGoodixGestureIdle, HOVER_AT_LAST},
+        /* ClickTimeout */  {kGoodixGestureIdle, CLICK}
+    },
+    // kGoodixGesturePressed
+    {
+        /* Down */          {kGoodixGesturePressed, 0},
+        /* Still */         {kGoodixGesturePressed, HOVER_AT_POS | ARM_CLICK},
+        /* Hold */          {kGoodixGestureRightClicked, CANCEL_CLICK | CANCEL_HOLD | RIGHT_AT_POS | HOVER_AT_POS},
+        /* NearMove */      {kGoodixGestureDragging, CANCEL_CLICK | CANCEL_HOLD | LEFT_AT_NEXT | LEFT_AT_POS | UPDATE_NEXT},
+        /* FarMove */       {kGoodixGestureDragging, CANCEL_CLICK | CANCEL_HOLD | LEFT_AT_NEXT | LEFT_AT_POS | UPDATE_NEXT},
+        /* Lift */          {kGoodixGestureIdle, CANCEL_HOLD | HOVER_AT_LAST},
+        /* ClickTimeout */  {kGoodixGesturePressed, 0}
+    },
+    // kGoodixGestureDragging
+    {
+        /* Down */          {kGoodixGestureDragging, 0},
+        /* Still */         {kGoodixGestureDragging, LEFT_AT_POS},
+        /* Hold */          {kGoodixGestureDragging, LEFT_AT_POS},
+        /* NearMove */      {kGoodixGestureDragging, LEFT_AT_POS | UPDATE_NEXT},
+        /* FarMove */       {kGoodixGestureDragging, LEFT_AT_POS | UPDATE_NEXT},
+        /* Lift */          {kGoodixGestureIdle, HOVER_AT_LAST},
+        /* ClickTimeout */  {kGoodixGestureDragging, 0}
+    },
+    // kGoodixGestureRightClicked
+    {
+        /* Down */          {kGoodixGestureRightClicked, 0},
+        /* Still */         {kGoodixGestureRightClicked, HOVER_AT_POS},
+        /* Hold */          {kGoodixGestureRightClicked, HOVER_AT_POS},
+        /* NearMove */      {kGoodixGestureRightClicked, HOVER_AT_POS},
+        /* FarMove */       {kGoodixGestureRightClickMoved, HOVER_AT_POS | UPDATE_NEXT},
+        /* Lift */          {kGoodixGestureIdle, HOVER_AT_LAST},
+        /* ClickTimeout */  {kGoodixGestureRightClicked, 0}
+    },
+    // kGoodixGestureRightClickMoved
+    {
+        /* Down */          {kGoodixGestureRightClickMoved, 0},
+        /* Still */         {kGoodixGestureRightClickMoved, HOVER_AT_POS},
+        /* Hold */          {kGoodixGestureRightClickMoved, HOVER_AT_POS},
+        /* NearMove */      {kGoodixGestureRightClickMoved, HOVER_AT_POS},
+        /* FarMove */       {kGoodixGestureRightClickMoved, HOVER_AT_POS | UPDATE_NEXT},
+        /* Lift */          {kGoodixGestureIdle, RELEASE_AT_NEXT | HOVER_AT_LAST},
+        /* ClickTimeout */  {kGoodixGestureRightClickMoved, 0}
+    }
+};
+
+void VoodooI2CGoodixGestureMachine::reset() {
+    state = kGoodixGestureIdle;
+    lastEvent = kGoodixGestureLift;
+    nextX = 0;
+    nextY = 0;
+    downStart = 0;
+    lastClickX = 0;
+    lastClickY = 0;
+    lastClickTime = 0;
+    count = 0;
+}
+
+int VoodooI2CGoodixGestureMachine::frame(int x, int y, uint64_t nanoseconds) {
+    VoodooI2CGoodixGestureEvent event;
+    if (state == kGoodixGestureIdle) {
+        event = kGoodixGestureDown;
+    }
+    else if (x == nextX && y == nextY) {
+        event = (nanoseconds - downStart) / 1000000 >= RIGHT_CLICK_DELAY ? kGoodixGestureHold : kGoodixGestureStill;
+    }
+    else {
+        event = isClose(x, y, nextX, nextY) ? kGoodixGestureNearMove : kGoodixGestureFarMove;
+    }
+    return handle(event, x, y, nanoseconds);
+}
+
+int VoodooI2CGoodixGestureMachine::handle(VoodooI2CGoodixGestureEvent event, int x, int y, uint64_t nanoseconds) {
+    const Transition& transition = transitions[state][event];
+    uint16_t actions = transition.actions;
+    lastEvent = event;
+    count = 0;
+
+    if (actions & CANCEL_CLICK) {
+        output(kGoodixGestureCancelClick);
+    }
+    if (actions & CANCEL_HOLD) {
+        output(kGoodixGestureCancelHold);
+    }
+    if (actions & SET_ORIGIN) {
+        downStart = nanoseconds;
+        nextX = x;
+        nextY = y;
+    }
+    if (actions & LEFT_AT_NEXT) {
+        output(kGoodixGestureDispatch, kGoodixGestureButtonLeft, nextX, nextY);
+    }
+    if (actions & RIGHT_AT_POS) {
+        output(kGoodixGestureDispatch, kGoodixGestureButtonRight, x, y);
+    }
+    if (actions & LEFT_AT_POS) {
+        output(kGoodixGestureDispatch, kGoodixGestureButtonLeft, x, y);
+    }
+    if (actions & HOVER_AT_POS) {
+        output(kGoodixGestureDispatch, kGoodixGestureButtonNone, x, y);
+    }
+    if (actions & UPDATE_NEXT) {
+        nextX = x;
+        nextY = y;
+    }
+    if (actions & ARM_CLICK) {
+        output(kGoodixGestureArmClick);
+    }
+    if (actions & ARM_HOLD) {
+        output(kGoodixGestureArmHold);
+    }
+    if (actions & RELEASE_AT_NEXT) {
+        output(kGoodixGestureDispatch, kGoodixGestureButtonLeft, nextX, nextY);
+        output(kGoodixGestureDispatch, kGoodixGestureButtonNone, nextX, nextY);
+    }
+    if (actions & HOVER_AT_LAST) {
+        output(kGoodixGestureLiftHover);
+    }
+    if (actions & CLICK) {
+        // A second click close to the first is sent as a double click, where the first one was
+        if (isClose(lastClickX, lastClickY, nextX, nextY) && (nanoseconds - lastClickTime) / 1000000 <= DOUBLE_CLICK_TIME) {
+            nextX = lastClickX;
+            nextY = lastClickY;
+            output(kGoodixGestureDispatch, kGoodixGestureButtonLeft, nextX, nextY);
+            output(kGoodixGestureDispatch, kGoodixGestureButtonNone, nextX, nextY);
+        }
+        output(kGoodixGestureDispatch, kGoodixGestureButtonLeft, nextX, nextY);
+        output(kGoodixGestureDispatch, kGoodixGestureButtonNone, nextX, nextY);
+
+        lastClickTime = nanoseconds;
+        lastClickX = nextX;
+        lastClickY = nextY;
+    }
+
+    state = (VoodooI2CGoodixGestureState)transition.next;
+    return count;
+}
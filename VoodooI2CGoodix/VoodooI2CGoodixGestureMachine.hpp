@@ -0,0 +1,185 @@
+//
+//  VoodooI2CGoodixGestureMachine.hpp
+//  VoodooI2CGoodix
+//
+//  Created by agent on 10/17/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef VoodooI2CGoodixGestureMachine_hpp
+#define VoodooI2CGoodixGestureMachine_hpp
+
+#include <stdint.h>
+
+#define RIGHT_CLICK_DELAY       500
+#define DOUBLE_CLICK_FAT_ZONE   40
+#define DOUBLE_CLICK_TIME       450
+
+/* The most commands a single event can produce, a double click */
+#define GOODIX_GESTURE_MAX_OUTPUTS  4
+
+enum VoodooI2CGoodixGestureState {
+    kGoodixGestureIdle,             // no finger on the screen
+    kGoodixGesturePressed,          // a finger is down and hasn't moved
+    kGoodixGestureDragging,         // a finger moved while down, the left button is held
+    kGoodixGestureRightClicked,     // a finger was held still long enough to right click
+    kGoodixGestureRightClickMoved,  // the finger moved away after a right click, lifting it clicks where it is
+    kGoodixGestureStateCount
+};
+
+enum VoodooI2CGoodixGestureEvent {
+    kGoodixGestureDown,             // a frame while no finger was down
+    kGoodixGestureStill,            // a frame at the same position as the last one
+    kGoodixGestureHold,             // the hold timer fired, or a still frame came RIGHT_CLICK_DELAY after the finger went down
+    kGoodixGestureNearMove,         // a frame within DOUBLE_CLICK_FAT_ZONE of the last position
+    kGoodixGestureFarMove,          // a frame further away than that
+    kGoodixGestureLift,             // the finger lifted
+    kGoodixGestureClickTimeout,     // the click timer armed by a still frame fired
+    kGoodixGestureEventCount
+};
+
+/* Values of <VoodooI2CGoodixGestureOutput::button>, which match the event driver's click types */
+enum {
+    kGoodixGestureButtonNone  = 0x0,
+    kGoodixGestureButtonLeft  = 0x1,
+    kGoodixGestureButtonRight = 0x2
+};
+
+enum VoodooI2CGoodixGestureCommand {
+    kGoodixGestureDispatch,         // dispatch a digitizer event with <button> at <x>, <y>
+    kGoodixGestureLiftHover,        // dispatch a hover where the last digitizer event was
+    kGoodixGestureArmClick,         // (re)start the click timer
+    kGoodixGestureCancelClick,      // stop the click timer
+    kGoodixGestureArmHold,          // start the hold timer, RIGHT_CLICK_DELAY after the finger went down
+    kGoodixGestureCancelHold,       // stop the hold timer
+    kGoodixGestureLifted            // never produced by the machine, the scheduler's lift of every finger
+};
+
+struct VoodooI2CGoodixGestureOutput {
+    VoodooI2CGoodixGestureCommand command;
+    uint8_t button;
+    int x;
+    int y;
+};
+
+/* Turns single finger frames into clicks, drags, right clicks and double clicks
+ *
+ * Every (state, event) pair maps to the next state and a set of actions in a fixed table. The
+ * machine doesn't dispatch anything or own any timers itself, it produces commands that the
+ * caller executes in order, so it has no dependencies on IOKit and never allocates.
+ */
+
+class VoodooI2CGoodixGestureMachine {
+ public:
+    VoodooI2CGoodixGestureMachine() {
+        reset();
+    }
+
+    /* Forget the current gesture and the last click
+     */
+
+    void reset();
+
+    /* Handle a single finger frame
+     * @x The logical X position of the finger
+     * @y The logical Y position of the finger
+     * @nanoseconds When the frame was signalled
+     *
+     * @return the number of commands, which are read with <getOutputs>
+     */
+
+    int frame(int x, int y, uint64_t nanoseconds);
+
+    /* Handle the finger lifting
+     */
+
+    int lift(uint64_t nanoseconds) {
+        return handle(kGoodixGestureLift, nextX, nextY, nanoseconds);
+    }
+
+    /* Handle the click timer firing
+     */
+
+    int clickTimeout(uint64_t nanoseconds) {
+        return handle(kGoodixGestureClickTimeout, nextX, nextY, nanoseconds);
+    }
+
+    /* Handle the hold timer firing, the finger is still where it went down
+     */
+
+    int hold(uint64_t nanoseconds) {
+        return handle(kGoodixGestureHold, nextX, nextY, nanoseconds);
+    }
+
+    /* Apply an event directly, <frame> picks the event for a frame
+     *
+     * @return the number of commands, which are read with <getOutputs>
+     */
+
+    int handle(VoodooI2CGoodixGestureEvent event, int x, int y, uint64_t nanoseconds);
+
+    const VoodooI2CGoodixGestureOutput* getOutputs() const {
+        return outputs;
+    }
+
+    VoodooI2CGoodixGestureState getState() const {
+        return state;
+    }
+
+    /* The event that was handled last
+     */
+
+    VoodooI2CGoodixGestureEvent getLastEvent() const {
+        return lastEvent;
+    }
+
+    /* Where the finger went down or last moved to, where the next click goes
+     */
+
+    int getX() const {
+        return nextX;
+    }
+
+    int getY() const {
+        return nextY;
+    }
+
+    /* Whether a finger is down as far as gestures are concerned
+     */
+
+    bool isDown() const {
+        return state != kGoodixGestureIdle;
+    }
+
+ private:
+    VoodooI2CGoodixGestureState state;
+    VoodooI2CGoodixGestureEvent lastEvent;
+
+    // Where the finger went down, or last moved to, and when it went down
+    int nextX;
+    int nextY;
+    uint64_t downStart;
+
+    int lastClickX;
+    int lastClickY;
+    uint64_t lastClickTime;
+
+    VoodooI2CGoodixGestureOutput outputs[GOODIX_GESTURE_MAX_OUTPUTS];
+    int count;
+
+    bool isClose(int x, int y, int otherX, int otherY) const {
+        int dx = x - otherX;
+        int dy = y - otherY;
+        return dx <= DOUBLE_CLICK_FAT_ZONE && dx >= -DOUBLE_CLICK_FAT_ZONE && dy <= DOUBLE_CLICK_FAT_ZONE && dy >= -DOUBLE_CLICK_FAT_ZONE;
+    }
+
+    void output(VoodooI2CGoodixGestureCommand command, uint8_t button = kGoodixGestureButtonNone, int x = 0, int y = 0) {
+        VoodooI2CGoodixGestureOutput& out = outputs[count++];
+        out.command = command;
+        out.button = button;
+        out.x = x;
+        out.y = y;
+    }
+};
+
+#endif /* VoodooI2CGoodixGestureMachine_hpp */
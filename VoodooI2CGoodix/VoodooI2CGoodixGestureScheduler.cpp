@@ -0,0 +1,160 @@
+//
+//  VoodooI2CGoodixGestureScheduler.cpp
+//  VoodooI2CGoodix
+//
+//  Created by agent on 10/17/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include "VoodooI2CGoodixGestureScheduler.hpp"
+
+void VoodooI2CGoodixGestureScheduler::reset() {
+    gestures.reset();
+    eventNanoseconds = 0;
+    liftScheduled = false;
+    liftDeadline = 0;
+    holdDeadline = 0;
+}
+
+void VoodooI2CGoodixGestureScheduler::setClock(VoodooI2CGoodixClock* newClock) {
+    if (newClock == clock) {
+        return;
+    }
+    if (clock) {
+        for (int i = 0; i < kGoodixTimerCount; i++) {
+            clock->cancel((VoodooI2CGoodixTimerID)i);
+        }
+    }
+    reset();
+    clock = newClock;
+}
+
+int VoodooI2CGoodixGestureScheduler::frame(int x, int y) {
+    count = 0;
+
+    // The hold timer may not have had a chance to fire yet, it still comes first
+    holdIfDue(eventNanoseconds);
+
+    VoodooI2CGoodixGestureState from = gestures.getState();
+    run(from, gestures.frame(x, y, eventNanoseconds));
+
+    // No matter what, we need to ensure we issue a mouseup after some time
+    scheduleLift();
+    return count;
+}
+
+void VoodooI2CGoodixGestureScheduler::multitouch() {
+    // Cancel our outstanding click and hold, we're multitouching
+    clock->cancel(kGoodixTimerClick);
+    clock->cancel(kGoodixTimerHold);
+
+    // Make sure we schedule a lift for when the gesture ends to reset state
+    scheduleLift();
+}
+
+int VoodooI2CGoodixGestureScheduler::liftNow() {
+    count = 0;
+    if (liftScheduled) {
+        clock->cancel(kGoodixTimerLift);
+        lift(eventNanoseconds);
+    }
+    return count;
+}
+
+int VoodooI2CGoodixGestureScheduler::timerFired(VoodooI2CGoodixTimerID timer) {
+    count = 0;
+    UInt64 nanoseconds = clock->getNanoseconds();
+    switch (timer) {
+        case kGoodixTimerLift:
+            // Frames arrived since the timer was armed, so wait until the last of them goes stale
+            if (nanoseconds < liftDeadline) {
+                clock->setDeadline(kGoodixTimerLift, liftDeadline);
+                break;
+            }
+            setEventTime(nanoseconds);
+            lift(liftDeadline);
+            break;
+        case kGoodixTimerClick: {
+            // Only does anything if the finger was lifted within click time
+            setEventTime(nanoseconds);
+            VoodooI2CGoodixGestureState from = gestures.getState();
+            run(from, gestures.clickTimeout(eventNanoseconds));
+            break;
+        }
+        case kGoodixTimerHold: {
+            // The finger hasn't moved since it went down
+            setEventTime(nanoseconds);
+            VoodooI2CGoodixGestureState from = gestures.getState();
+            run(from, gestures.hold(eventNanoseconds));
+            break;
+        }
+        default:
+            break;
+    }
+    return count;
+}
+
+void VoodooI2CGoodixGestureScheduler::scheduleLift() {
+    liftDeadline = eventNanoseconds + FINGER_LIFT_DELAY * 1000000ULL;
+    if (!liftScheduled) {
+        liftScheduled = true;
+        clock->setDeadline(kGoodixTimerLift, clock->getNanoseconds() + FINGER_LIFT_DELAY * 1000000ULL);
+    }
+}
+
+void VoodooI2CGoodixGestureScheduler::holdIfDue(UInt64 time) {
+    if (!clock->isArmed(kGoodixTimerHold) || holdDeadline > time) {
+        return;
+    }
+    clock->cancel(kGoodixTimerHold);
+    VoodooI2CGoodixGestureState from = gestures.getState();
+    run(from, gestures.hold(eventNanoseconds));
+}
+
+void VoodooI2CGoodixGestureScheduler::lift(UInt64 time) {
+    liftScheduled = false;
+
+    // A finger held until its hold deadline right clicks before it lifts, even if the timer hasn't fired
+    holdIfDue(time);
+
+    // Ends the gesture, clicking where the finger went if it moved after a right click
+    VoodooI2CGoodixGestureState from = gestures.getState();
+    run(from, gestures.lift(eventNanoseconds));
+
+    VoodooI2CGoodixGestureOutput& out = outputs[count++];
+    out.command = kGoodixGestureLifted;
+    out.button = kGoodixGestureButtonNone;
+    out.x = 0;
+    out.y = 0;
+}
+
+void VoodooI2CGoodixGestureScheduler::run(VoodooI2CGoodixGestureState from, int machineCount) {
+    if (observer) {
+        observer(observerTarget, from, gestures);
+    }
+
+    const VoodooI2CGoodixGestureOutput* machineOutputs = gestures.getOutputs();
+    for (int i = 0; i < machineCount; i++) {
+        const VoodooI2CGoodixGestureOutput& output = machineOutputs[i];
+        switch (output.command) {
+            case kGoodixGestureArmClick:
+                // Wait a tick to begin the click check, this helps avoid phantom clicks
+                clock->setDeadline(kGoodixTimerClick, clock->getNanoseconds() + CLICK_DELAY * 1000000ULL);
+                break;
+            case kGoodixGestureCancelClick:
+                clock->cancel(kGoodixTimerClick);
+                break;
+            case kGoodixGestureArmHold:
+                // Counted from when the finger went down, not from when its frame was reported
+                holdDeadline = eventNanoseconds + RIGHT_CLICK_DELAY * 1000000ULL;
+                clock->setDeadline(kGoodixTimerHold, holdDeadline);
+                break;
+            case kGoodixGestureCancelHold:
+                clock->cancel(kGoodixTimerHold);
+                break;
+            default:
+                outputs[count++] = output;
+                break;
+        }
+    }
+}
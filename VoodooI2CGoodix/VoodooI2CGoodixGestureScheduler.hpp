@@ -0,0 +1,184 @@
+//
+//  VoodooI2CGoodixGestureScheduler.hpp
+//  VoodooI2CGoodix
+//
+//  Created by agent on 10/17/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef VoodooI2CGoodixGestureScheduler_hpp
+#define VoodooI2CGoodixGestureScheduler_hpp
+
+#include "./VoodooI2CGoodixClock.hpp"
+#include "./VoodooI2CGoodixGestureMachine.hpp"
+
+#define FINGER_LIFT_DELAY   50 // watchdog for lost lift reports
+#define CLICK_DELAY         100
+
+/* The most commands a single call can produce, the gesture machine's commands and the lift */
+#define GOODIX_SCHEDULER_MAX_OUTPUTS  (2 * GOODIX_GESTURE_MAX_OUTPUTS + 1)
+
+/* Called after the gesture machine handles an event
+ * @target The target the scheduler was given
+ * @from The state the machine was in before the event
+ * @gestures The machine, whose last event and state are the transition
+ */
+
+typedef void (*VoodooI2CGoodixGestureObserver)(void* target, VoodooI2CGoodixGestureState from, const VoodooI2CGoodixGestureMachine& gestures);
+
+/* Drives the gesture machine from frames and the timers it arms on a clock
+ *
+ * Owns the lift watchdog, the click timer and the hold timer, and executes the gesture machine's
+ * timer commands itself, so only the commands that dispatch events are left for the caller. It
+ * has no dependencies on IOKit, so the same timing can be run against a <VoodooI2CGoodixVirtualClock>.
+ *
+ * A finger held still right clicks at RIGHT_CLICK_DELAY whether or not frames keep coming. The
+ * hold only happens if its deadline comes before the lift, the lift report or the watchdog's
+ * deadline, and it's handled first when both are due at once.
+ *
+ * The clock's action must call <timerFired>, everything must be called from the same thread as
+ * the clock fires its timers on.
+ */
+
+class VoodooI2CGoodixGestureScheduler {
+ public:
+    VoodooI2CGoodixGestureScheduler() : clock(NULL), observer(NULL), observerTarget(NULL), count(0) {
+        reset();
+    }
+
+    /* Arm timers and read time through another clock
+     * @newClock The clock to use
+     *
+     * Timers armed on the previous clock are cancelled and the gesture in progress is forgotten,
+     * times from different clocks can't be compared.
+     */
+
+    void setClock(VoodooI2CGoodixClock* newClock);
+
+    VoodooI2CGoodixClock* getClock() const {
+        return clock;
+    }
+
+    /* Set what's called after every gesture machine transition
+     */
+
+    void setObserver(VoodooI2CGoodixGestureObserver newObserver, void* target) {
+        observer = newObserver;
+        observerTarget = target;
+    }
+
+    /* Set the time of the frame being reported
+     * @nanoseconds When the panel signalled it on the clock, earlier times are ignored
+     */
+
+    void setEventTime(UInt64 nanoseconds) {
+        if (nanoseconds > eventNanoseconds) {
+            eventNanoseconds = nanoseconds;
+        }
+    }
+
+    /* When the frame being reported was signalled, or when the timer being handled fired
+     */
+
+    UInt64 getEventNanoseconds() const {
+        return eventNanoseconds;
+    }
+
+    /* Handle a single finger frame at the event time
+     *
+     * @return the number of commands, which are read with <getOutputs>
+     */
+
+    int frame(int x, int y);
+
+    /* Keep the fingers down for a frame that isn't a single finger gesture, e.g. a stylus
+     */
+
+    void touching() {
+        scheduleLift();
+    }
+
+    /* Keep the fingers down for a multitouch frame, which ends any single finger click or hold
+     */
+
+    void multitouch();
+
+    /* Lift the fingers if they're down, when the panel reports that the last one lifted
+     *
+     * @return the number of commands, which are read with <getOutputs>
+     */
+
+    int liftNow();
+
+    /* Handle a timer firing, moving the event time to the clock's time
+     *
+     * @return the number of commands, which are read with <getOutputs>
+     */
+
+    int timerFired(VoodooI2CGoodixTimerID timer);
+
+    /* The commands for the caller, only kGoodixGestureDispatch, kGoodixGestureLiftHover and
+     * kGoodixGestureLifted, in the order they have to be executed
+     */
+
+    const VoodooI2CGoodixGestureOutput* getOutputs() const {
+        return outputs;
+    }
+
+    const VoodooI2CGoodixGestureMachine& getGestures() const {
+        return gestures;
+    }
+
+    /* Whether the lift watchdog is armed, i.e. something is touching
+     */
+
+    bool isTouching() const {
+        return liftScheduled;
+    }
+
+ private:
+    VoodooI2CGoodixClock* clock;
+    VoodooI2CGoodixGestureObserver observer;
+    void* observerTarget;
+
+    VoodooI2CGoodixGestureMachine gestures;
+    UInt64 eventNanoseconds;
+
+    // Whether the lift watchdog is armed, and when it should lift the fingers
+    bool liftScheduled;
+    UInt64 liftDeadline;
+
+    // When the hold timer right clicks, if it's armed
+    UInt64 holdDeadline;
+
+    VoodooI2CGoodixGestureOutput outputs[GOODIX_SCHEDULER_MAX_OUTPUTS];
+    int count;
+
+    void reset();
+
+    /* Arm the lift watchdog, it's only armed once and later frames just move the deadline
+     */
+
+    void scheduleLift();
+
+    /* Right click now if the hold timer is armed and due
+     * @time The time of the frame or lift that's about to be handled
+     */
+
+    void holdIfDue(UInt64 time);
+
+    /* Lift the fingers, the watchdog must already be disarmed
+     * @time When the fingers lifted, the hold is handled first if it was due by then
+     */
+
+    void lift(UInt64 time);
+
+    /* Execute the timer commands of a gesture machine transition and keep the others
+     * @from The state the machine was in before the event
+     * @machineCount The number of commands the machine produced
+     */
+
+    void run(VoodooI2CGoodixGestureState from, int machineCount);
+};
+
+#endif /* VoodooI2CGoodixGestureScheduler_hpp */
@@ -0,0 +1,157 @@
+//
+//  VoodooI2CGoodixLatencyHistogram.hpp
+//  VoodooI2CGoodix
+//
+//  Created by agent on 10/17/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef VoodooI2CGoodixLatencyHistogram_hpp
+#define VoodooI2CGoodixLatencyHistogram_hpp
+
+#include <stdint.h>
+
+#ifdef KERNEL
+#include <libkern/c++/OSDictionary.h>
+#include <libkern/c++/OSNumber.h>
+#endif
+
+/* A fixed-size histogram of latencies in microseconds
+ *
+ * Samples past the last bucket are counted in the last bucket. When DecayThreshold is set,
+ * every bucket is halved once that many samples have been recorded, so the histogram follows
+ * the recent behaviour of the panel rather than its whole history.
+ */
+
+template <unsigned BucketCount, uint32_t BucketWidth, uint32_t DecayThreshold = 0>
+class VoodooI2CGoodixLatencyHistogram {
+ public:
+    VoodooI2CGoodixLatencyHistogram() {
+        reset();
+    }
+
+    /* Forget all recorded samples
+     */
+
+    void reset() {
+        for (unsigned i = 0; i < BucketCount; i++) {
+            buckets[i] = 0;
+        }
+        total = 0;
+        maximum = 0;
+    }
+
+    /* Record a single sample
+     * @latency The latency in microseconds
+     */
+
+    void record(uint64_t latency) {
+        uint64_t bucket = latency / BucketWidth;
+        if (bucket >= BucketCount) {
+            bucket = BucketCount - 1;
+        }
+
+        buckets[bucket]++;
+        total++;
+        if (latency > maximum) {
+            maximum = latency;
+        }
+
+        if (DecayThreshold && total >= DecayThreshold) {
+            total = 0;
+            for (unsigned i = 0; i < BucketCount; i++) {
+                buckets[i] /= 2;
+                total += buckets[i];
+            }
+        }
+    }
+
+    /* The number of samples currently held
+     */
+
+    uint32_t count() const {
+        return total;
+    }
+
+    /* The largest sample recorded since the last reset
+     */
+
+    uint64_t max() const {
+        return maximum;
+    }
+
+    /* Like <percentile>, but returns the lower edge of the bucket in microseconds
+     */
+
+    uint64_t percentileFloor(unsigned percent) const {
+        return percentileBucket(percent) * (uint64_t)BucketWidth;
+    }
+
+    /* Find the bucket that holds the given percentile
+     * @percent The percentile to look up (0-100)
+     *
+     * @return the upper edge of the bucket in microseconds, or 0 if there are no samples
+     */
+
+    uint64_t percentile(unsigned percent) const {
+        if (!total) {
+            return 0;
+        }
+        return (percentileBucket(percent) + 1) * (uint64_t)BucketWidth;
+    }
+
+#ifdef KERNEL
+    /* Add the median, p99 and max to a statistics dictionary
+     * @dict The dictionary to add them to
+     * @key The name of the dictionary that holds them
+     */
+
+    void publish(OSDictionary* dict, const char* key) const {
+        OSDictionary* latency = OSDictionary::withCapacity(3);
+        if (!latency) {
+            return;
+        }
+
+        const char* names[] = {"p50 (us)", "p99 (us)", "Max (us)"};
+        uint64_t values[] = {percentile(50), percentile(99), max()};
+        for (int i = 0; i < 3; i++) {
+            OSNumber* number = OSNumber::withNumber(values[i], 64);
+            if (number) {
+                latency->setObject(names[i], number);
+                number->release();
+            }
+        }
+
+        dict->setObject(key, latency);
+        latency->release();
+    }
+#endif
+
+ private:
+    uint32_t buckets[BucketCount];
+    uint32_t total;
+    uint64_t maximum;
+
+    unsigned percentileBucket(unsigned percent) const {
+        if (!total) {
+            return 0;
+        }
+
+        // The rank of the sample we're after, rounded up so that p0 is the first sample
+        uint64_t rank = ((uint64_t)total * percent + 99) / 100;
+        if (rank == 0) {
+            rank = 1;
+        }
+
+        uint64_t seen = 0;
+        for (unsigned i = 0; i < BucketCount; i++) {
+            seen += buckets[i];
+            if (seen >= rank) {
+                return i;
+            }
+        }
+        return BucketCount - 1;
+    }
+};
+
+#endif /* VoodooI2CGoodixLatencyHistogram_hpp */
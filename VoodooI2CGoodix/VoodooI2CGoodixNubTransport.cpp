@@ -0,0 +1,45 @@
+//
+//  VoodooI2CGoodixNubTransport.cpp
+//  VoodooI2CGoodix
+//
+//  Created by agent on 10/17/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include "VoodooI2CGoodixNubTransport.hpp"
+#include <libkern/OSByteOrder.h>
+
+VoodooI2CGoodixNubTransport::VoodooI2CGoodixNubTransport(VoodooI2CDeviceNub* api) : api(api) {}
+
+IOReturn VoodooI2CGoodixNubTransport::readVersion(UInt8* values, size_t len) {
+    return readRegister(GOODIX_REG_ID, values, len);
+}
+
+IOReturn VoodooI2CGoodixNubTransport::readConfig(UInt16 reg, UInt8* values, size_t len) {
+    return readRegister(reg, values, len);
+}
+
+IOReturn VoodooI2CGoodixNubTransport::readReport(UInt16 offset, UInt8* values, size_t len) {
+    return readRegister(GOODIX_READ_COOR_ADDR + offset, values, len);
+}
+
+IOReturn VoodooI2CGoodixNubTransport::endCmd() {
+    return writeRegister(GOODIX_READ_COOR_ADDR, 0);
+}
+
+/* Adapted from the TFE Driver */
+IOReturn VoodooI2CGoodixNubTransport::readRegister(UInt16 reg, UInt8* values, size_t len) {
+    UInt16 buffer[] {
+        OSSwapHostToBigInt16(reg)
+    };
+    return api->writeReadI2C(reinterpret_cast<UInt8*>(&buffer), sizeof(buffer), values, len);
+}
+
+/* Adapted from the TFE Driver */
+IOReturn VoodooI2CGoodixNubTransport::writeRegister(UInt16 reg, UInt8 value) {
+    UInt16 buffer[] {
+        OSSwapHostToBigInt16(reg),
+        value
+    };
+    return api->writeI2C(reinterpret_cast<UInt8*>(&buffer), sizeof(buffer));
+}
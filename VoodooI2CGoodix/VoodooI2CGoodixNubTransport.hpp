@@ -0,0 +1,37 @@
+//
+//  VoodooI2CGoodixNubTransport.hpp
+//  VoodooI2CGoodix
+//
+//  Created by agent on 10/17/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef VoodooI2CGoodixNubTransport_hpp
+#define VoodooI2CGoodixNubTransport_hpp
+
+#include "../../../VoodooI2C/VoodooI2C/VoodooI2CDevice/VoodooI2CDeviceNub.hpp"
+#include "./VoodooI2CGoodixTransport.hpp"
+
+/* Talks to the panel over I2C through the VoodooI2C device nub
+ */
+
+class VoodooI2CGoodixNubTransport : public VoodooI2CGoodixTransport {
+ public:
+    /* @api The nub of the panel, which must stay open while the transport is in use
+     */
+
+    explicit VoodooI2CGoodixNubTransport(VoodooI2CDeviceNub* api);
+
+    IOReturn readVersion(UInt8* values, size_t len) override;
+    IOReturn readConfig(UInt16 reg, UInt8* values, size_t len) override;
+    IOReturn readReport(UInt16 offset, UInt8* values, size_t len) override;
+    IOReturn endCmd() override;
+
+ private:
+    VoodooI2CDeviceNub* api;
+
+    IOReturn readRegister(UInt16 reg, UInt8* values, size_t len);
+    IOReturn writeRegister(UInt16 reg, UInt8 value);
+};
+
+#endif /* VoodooI2CGoodixNubTransport_hpp */
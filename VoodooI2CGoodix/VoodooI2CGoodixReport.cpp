@@ -0,0 +1,66 @@
+//
+//  VoodooI2CGoodixReport.cpp
+//  VoodooI2CGoodix
+//
+//  Created by agent on 10/17/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include "VoodooI2CGoodixReport.hpp"
+
+/* Ported from goodix.c */
+int goodix_read_report(VoodooI2CGoodixTransport* transport, UInt8* data, int predicted_touch_num, int max_touch_num) {
+    // Speculatively read the status byte, as many touches as the last report had, and the pen buttons
+    if (transport->readReport(0, data, 1 + GOODIX_CONTACT_SIZE * predicted_touch_num + 1) != kIOReturnSuccess) {
+        return GOODIX_REPORT_ERROR;
+    }
+    if (!(data[0] & GOODIX_BUFFER_STATUS_READY)) {
+        return GOODIX_REPORT_NOT_READY;
+    }
+
+    int touch_num = data[0] & 0x0f;
+    if (touch_num > max_touch_num) {
+        return GOODIX_REPORT_INVALID;
+    }
+
+    if (touch_num > predicted_touch_num) {
+        // Read the touches we didn't guess, and 1 additional byte for the pen buttons
+        int offset = 1 + GOODIX_CONTACT_SIZE * predicted_touch_num;
+        if (transport->readReport(offset, data + offset, GOODIX_CONTACT_SIZE * (touch_num - predicted_touch_num) + 1) != kIOReturnSuccess) {
+            return GOODIX_REPORT_ERROR;
+        }
+    }
+
+    return touch_num;
+}
+
+/* Ported from goodix.c */
+void goodix_decode_report(const UInt8* data, int touch_num, const VoodooI2CGoodixTransform& transform, TouchFrame* frame) {
+    UInt8 keys = data[1 + touch_num * GOODIX_CONTACT_SIZE];
+    if (GOODIX_KEYDOWN_EVENT(keys)) {
+        frame->stylusButton1 = GOODIX_IS_STYLUS_BTN_DOWN(keys, GOODIX_STYLUS_BTN1);
+        frame->stylusButton2 = GOODIX_IS_STYLUS_BTN_DOWN(keys, GOODIX_STYLUS_BTN2);
+    }
+    else {
+        frame->stylusButton1 = false;
+        frame->stylusButton2 = false;
+    }
+
+    frame->numTouches = 0;
+    for (int i = 0; i < touch_num; i++) {
+        const UInt8* coor_data = &data[1 + i * GOODIX_CONTACT_SIZE];
+        int id = coor_data[0] & 0x0F;
+
+        // The contact tracker can only follow the track IDs the panel can have
+        if (id >= GOODIX_MAX_CONTACTS) {
+            continue;
+        }
+
+        // Orient and calibrate
+        Touch& touch = frame->touches[frame->numTouches++];
+        transform.apply(get_unaligned_le16(&coor_data[1]), get_unaligned_le16(&coor_data[3]), &touch.x, &touch.y);
+        touch.width = get_unaligned_le16(&coor_data[5]);
+        touch.type = GOODIX_TOOL_TYPE(coor_data[0]) == GOODIX_TOOL_PEN;
+        touch.id = id;
+    }
+}
@@ -0,0 +1,63 @@
+//
+//  VoodooI2CGoodixReport.hpp
+//  VoodooI2CGoodix
+//
+//  Created by agent on 10/17/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef VoodooI2CGoodixReport_hpp
+#define VoodooI2CGoodixReport_hpp
+
+#include "./VoodooI2CGoodixContactTracker.hpp"
+#include "./VoodooI2CGoodixTransform.hpp"
+#include "./VoodooI2CGoodixTransport.hpp"
+#include "goodix.h"
+
+/* The status byte, every contact and the key byte */
+#define GOODIX_REPORT_MAX_LENGTH    (1 + GOODIX_CONTACT_SIZE * GOODIX_MAX_CONTACTS + 1)
+
+struct TouchFrame {
+    UInt64 timestamp; // nanoseconds of uptime when the panel signalled the frame
+    UInt64 readTimestamp; // nanoseconds of uptime when the report was read, 0 for replayed frames
+    struct Touch touches[GOODIX_MAX_CONTACTS]; // the first numTouches are valid, in the order the panel reported them
+    int numTouches;
+    bool stylusButton1;
+    bool stylusButton2;
+};
+
+/* Taken from the Linux kernel source */
+static inline uint16_t __get_unaligned_le16(const uint8_t *p) {
+    return p[0] | p[1] << 8;
+}
+
+static inline uint16_t get_unaligned_le16(const void *p) {
+    return __get_unaligned_le16((const uint8_t *)p);
+}
+
+/* Read the coordinate report if the panel has one ready
+ * @transport The bus the panel is on
+ * @data Receives the report, at least GOODIX_REPORT_MAX_LENGTH bytes
+ * @predicted_touch_num The number of contacts to read along with the status byte, a report
+ *  with as many or fewer contacts is read in a single transfer
+ * @max_touch_num The most contacts the panel is configured to report
+ *
+ * The buffer status is not cleared, the caller sends the end command once it's done.
+ *
+ * @return the number of contacts, GOODIX_REPORT_NOT_READY if the buffer status bit isn't set,
+ *  GOODIX_REPORT_ERROR if a transfer failed, or GOODIX_REPORT_INVALID if the report has more
+ *  contacts than the panel is configured for
+ */
+int goodix_read_report(VoodooI2CGoodixTransport* transport, UInt8* data, int predicted_touch_num, int max_touch_num);
+
+/* Decode a report into a frame of touches
+ * @data The report, starting with the status byte
+ * @touch_num The number of contacts in the report
+ * @transform Takes report coordinates to logical ones
+ * @frame Receives the touches and the stylus buttons, its timestamps are left alone
+ *
+ * Contacts with a track ID the contact tracker can't follow are left out.
+ */
+void goodix_decode_report(const UInt8* data, int touch_num, const VoodooI2CGoodixTransform& transform, TouchFrame* frame);
+
+#endif /* VoodooI2CGoodixReport_hpp */
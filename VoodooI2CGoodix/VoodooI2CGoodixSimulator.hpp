@@ -0,0 +1,357 @@
+//
+//  VoodooI2CGoodixSimulator.hpp
+//  VoodooI2CGoodix
+//
+//  Created by agent on 10/17/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef VoodooI2CGoodixSimulator_hpp
+#define VoodooI2CGoodixSimulator_hpp
+
+#include "./VoodooI2CGoodixTransport.hpp"
+
+#define GOODIX_SIMULATOR_SCRIPT_LENGTH  128
+#define GOODIX_SIMULATOR_READY_DELAY    10000000
+
+struct VoodooI2CGoodixSimulatedContact {
+    UInt8 id;
+    UInt16 x;
+    UInt16 y;
+    UInt16 width;
+    bool pen;
+};
+
+/* A software model of a GT9xx/GT1x controller's register map
+ *
+ * The version and config blocks are filled in on <configure>, with a valid checksum. Frames,
+ * spurious interrupts and bus errors are scripted against the simulator's clock, and each frame's
+ * buffer status bit is only set once the configured ready delay has passed since its interrupt,
+ * like the real panel. Reports that are not acknowledged with <endCmd> before the next frame is
+ * ready, or that are still waiting to become ready when the next frame comes, are overwritten and
+ * counted as overruns.
+ */
+
+class VoodooI2CGoodixSimulator : public VoodooI2CGoodixMemoryTransport {
+ public:
+    typedef UInt64 (*Clock)(void* ref);
+
+    /* @clock Returns the current time in nanoseconds
+     * @clockRef Passed to the clock
+     */
+
+    VoodooI2CGoodixSimulator(Clock clock, void* clockRef) : clock(clock), clockRef(clockRef) {
+        readyDelay = GOODIX_SIMULATOR_READY_DELAY;
+        resetScript();
+    }
+
+    /* Fill in the version and config blocks
+     * @id The product ID, i.e. 911
+     * @version The firmware version
+     * @configReg The address of the config block for this chip
+     * @configLength The length of the config block for this chip, including the checksum and fresh bytes
+     * @xMax The X resolution
+     * @yMax The Y resolution
+     * @maxTouches The maximum number of contacts
+     * @refresh The refresh config nibble, the panel reports every 5 + refresh ms
+     */
+
+    void configure(UInt16 id, UInt16 version, UInt16 configReg, size_t configLength, UInt16 xMax, UInt16 yMax, UInt8 maxTouches, UInt8 refresh) {
+        // The ID is stored as up to 4 ASCII digits, padded with zeros
+        UInt8 block[6];
+        char digits[4];
+        int length = 0;
+        do {
+            digits[length++] = '0' + id % 10;
+            id /= 10;
+        } while (id && length < 4);
+
+        memset(block, 0, sizeof(block));
+        for (int i = 0; i < length; i++) {
+            block[i] = digits[length - 1 - i];
+        }
+        block[4] = version & 0xff;
+        block[5] = version >> 8;
+        writeRegisters(GOODIX_REG_ID, block, sizeof(block));
+
+        UInt8 config[GOODIX_CONFIG_MAX_LENGTH];
+        memset(config, 0, sizeof(config));
+        config[RESOLUTION_LOC] = xMax & 0xff;
+        config[RESOLUTION_LOC + 1] = xMax >> 8;
+        config[RESOLUTION_LOC + 2] = yMax & 0xff;
+        config[RESOLUTION_LOC + 3] = yMax >> 8;
+        config[MAX_CONTACTS_LOC] = maxTouches & 0x0f;
+        config[TRIGGER_LOC] = GOODIX_INT_TRIGGER;
+        config[REFRESH_LOC] = refresh & 0x0f;
+
+        UInt8 checksum = 0;
+        for (size_t i = 0; i < configLength - 2; i++) {
+            checksum += config[i];
+        }
+        config[configLength - 2] = (~checksum) + 1;
+        config[configLength - 1] = 1;
+        writeRegisters(configReg, config, configLength);
+    }
+
+    /* Set how long after its interrupt a frame's buffer status bit is set
+     * @delay The delay in nanoseconds
+     */
+
+    void setReadyDelay(UInt64 delay) {
+        readyDelay = delay;
+    }
+
+    /* Repeat the script forever
+     * @period The time in nanoseconds after which the script starts over, or 0 to play it once
+     */
+
+    void setLoop(UInt64 period) {
+        loopPeriod = period;
+    }
+
+    /* Forget the script and start the clock over at the current time
+     */
+
+    void resetScript() {
+        scriptLength = 0;
+        scriptPosition = 0;
+        scriptStart = clock(clockRef);
+        loopPeriod = 0;
+        pendingFrame = NULL;
+        pendingReadyAt = 0;
+        interruptPending = false;
+        failingTransfers = 0;
+        overruns = 0;
+    }
+
+    /* Script a frame of contacts
+     * @at When the panel raises the frame's interrupt, in nanoseconds from the start of the script
+     * @contacts The contacts in the frame
+     * @count The number of contacts, 0 for a lift
+     * @keys The key byte that follows the contacts
+     *
+     * @return false if the script is full
+     */
+
+    bool scriptFrame(UInt64 at, const VoodooI2CGoodixSimulatedContact* contacts, int count, UInt8 keys = 0) {
+        if (scriptLength == GOODIX_SIMULATOR_SCRIPT_LENGTH || count > GOODIX_MAX_CONTACTS) {
+            return false;
+        }
+
+        ScriptEvent& event = script[scriptLength++];
+        event.at = at;
+        event.kind = kFrame;
+        event.count = count;
+        event.keys = keys;
+        for (int i = 0; i < count; i++) {
+            event.contacts[i] = contacts[i];
+        }
+        return true;
+    }
+
+    /* Script an interrupt that never produces a report, like the panel does after a lift
+     * @at When the interrupt is raised, in nanoseconds from the start of the script
+     *
+     * @return false if the script is full
+     */
+
+    bool scriptSpuriousInterrupt(UInt64 at) {
+        if (scriptLength == GOODIX_SIMULATOR_SCRIPT_LENGTH) {
+            return false;
+        }
+
+        ScriptEvent& event = script[scriptLength++];
+        event.at = at;
+        event.kind = kSpurious;
+        return true;
+    }
+
+    /* Script bus errors
+     * @at When the errors start, in nanoseconds from the start of the script
+     * @transfers How many transfers fail from then on
+     *
+     * @return false if the script is full
+     */
+
+    bool scriptError(UInt64 at, int transfers) {
+        if (scriptLength == GOODIX_SIMULATOR_SCRIPT_LENGTH) {
+            return false;
+        }
+
+        ScriptEvent& event = script[scriptLength++];
+        event.at = at;
+        event.kind = kError;
+        event.count = transfers;
+        return true;
+    }
+
+    /* Check for, and clear, an interrupt raised since the last call
+     *
+     * @return true if the panel raised an interrupt
+     */
+
+    bool takeInterrupt() {
+        advance();
+        bool pending = interruptPending;
+        interruptPending = false;
+        return pending;
+    }
+
+    /* The number of frames that were overwritten before they were acknowledged
+     */
+
+    UInt32 getOverruns() const {
+        return overruns;
+    }
+
+    IOReturn readVersion(UInt8* values, size_t len) override {
+        IOReturn retVal = transfer();
+        if (retVal != kIOReturnSuccess) {
+            return retVal;
+        }
+        return VoodooI2CGoodixMemoryTransport::readVersion(values, len);
+    }
+
+    IOReturn readConfig(UInt16 reg, UInt8* values, size_t len) override {
+        IOReturn retVal = transfer();
+        if (retVal != kIOReturnSuccess) {
+            return retVal;
+        }
+        return VoodooI2CGoodixMemoryTransport::readConfig(reg, values, len);
+    }
+
+    IOReturn readReport(UInt16 offset, UInt8* values, size_t len) override {
+        IOReturn retVal = transfer();
+        if (retVal != kIOReturnSuccess) {
+            return retVal;
+        }
+        return VoodooI2CGoodixMemoryTransport::readReport(offset, values, len);
+    }
+
+    IOReturn endCmd() override {
+        IOReturn retVal = transfer();
+        if (retVal != kIOReturnSuccess) {
+            return retVal;
+        }
+        return VoodooI2CGoodixMemoryTransport::endCmd();
+    }
+
+ private:
+    enum ScriptEventKind {
+        kFrame,
+        kSpurious,
+        kError
+    };
+
+    struct ScriptEvent {
+        UInt64 at;
+        ScriptEventKind kind;
+        int count;
+        UInt8 keys;
+        VoodooI2CGoodixSimulatedContact contacts[GOODIX_MAX_CONTACTS];
+    };
+
+    Clock clock;
+    void* clockRef;
+
+    ScriptEvent script[GOODIX_SIMULATOR_SCRIPT_LENGTH];
+    int scriptLength;
+    int scriptPosition;
+    UInt64 scriptStart;
+    UInt64 loopPeriod;
+
+    UInt64 readyDelay;
+    const ScriptEvent* pendingFrame;
+    UInt64 pendingReadyAt;
+    bool interruptPending;
+    int failingTransfers;
+    UInt32 overruns;
+
+    /* Play the script up to the current time and account for a transfer
+     *
+     * @return kIOReturnIOError if the transfer should fail, kIOReturnSuccess otherwise
+     */
+
+    IOReturn transfer() {
+        advance();
+        if (failingTransfers > 0) {
+            failingTransfers--;
+            return kIOReturnIOError;
+        }
+        return kIOReturnSuccess;
+    }
+
+    void advance() {
+        UInt64 now = clock(clockRef);
+
+        while (true) {
+            if (scriptPosition == scriptLength) {
+                if (!loopPeriod || !scriptLength || now < scriptStart + loopPeriod) {
+                    break;
+                }
+                scriptStart += loopPeriod;
+                scriptPosition = 0;
+            }
+
+            const ScriptEvent& event = script[scriptPosition];
+            UInt64 at = scriptStart + event.at;
+            if (at > now) {
+                break;
+            }
+
+            // A frame that became ready before this event has to be published first
+            publishPendingFrame(at);
+            scriptPosition++;
+
+            switch (event.kind) {
+                case kFrame:
+                    // The next scan replaces a frame that never became ready
+                    if (pendingReadyAt) {
+                        overruns++;
+                    }
+                    pendingFrame = &event;
+                    pendingReadyAt = at + readyDelay;
+                    interruptPending = true;
+                    break;
+                case kSpurious:
+                    interruptPending = true;
+                    break;
+                case kError:
+                    failingTransfers = event.count;
+                    break;
+            }
+        }
+
+        publishPendingFrame(now);
+    }
+
+    void publishPendingFrame(UInt64 now) {
+        if (!pendingReadyAt || now < pendingReadyAt) {
+            return;
+        }
+        pendingReadyAt = 0;
+
+        UInt8* status = &registers[GOODIX_READ_COOR_ADDR - GOODIX_REGISTER_BASE];
+        if (status[0] & GOODIX_BUFFER_STATUS_READY) {
+            overruns++;
+        }
+
+        UInt8* contact = status + 1;
+        for (int i = 0; i < pendingFrame->count; i++, contact += GOODIX_CONTACT_SIZE) {
+            const VoodooI2CGoodixSimulatedContact& source = pendingFrame->contacts[i];
+            contact[0] = (source.id & 0x0f) | (source.pen ? 0x80 : 0);
+            contact[1] = source.x & 0xff;
+            contact[2] = source.x >> 8;
+            contact[3] = source.y & 0xff;
+            contact[4] = source.y >> 8;
+            contact[5] = source.width & 0xff;
+            contact[6] = source.width >> 8;
+            contact[7] = 0;
+        }
+        contact[0] = pendingFrame->keys;
+
+        status[0] = GOODIX_BUFFER_STATUS_READY | pendingFrame->count;
+    }
+};
+
+#endif /* VoodooI2CGoodixSimulator_hpp */
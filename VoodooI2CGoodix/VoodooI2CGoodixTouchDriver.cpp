@@ -7,8 +7,8 @@
 //
 
 #include "VoodooI2CGoodixTouchDriver.hpp"
+#include <IOKit/IOUserClient.h>
 #include "goodix.h"
-#include <libkern/OSByteOrder.h>
 
 #define super IOService
 OSDefineMetaClassAndStructors(VoodooI2CGoodixTouchDriver, IOService);
@@ -28,6 +28,7 @@ struct goodix_ts_data {
     bool inverted_x;
     bool inverted_y;
     unsigned int max_touch_num;
+    unsigned int refresh_interval_ms;
     UInt16 id;
     UInt16 version;
 };
@@ -60,6 +61,11 @@ static const struct goodix_chip_data gt9x_chip_data = {
     .config_fresh_addr  = GOODIX_CONFIG_MAX_LENGTH - 1
 };
 
+static bool get_bool_property(IOService* service, const char* key) {
+    OSBoolean* value = OSDynamicCast(OSBoolean, service->getProperty(key));
+    return value && value->isTrue();
+}
+
 static const struct goodix_chip_data *goodix_get_chip_data(UInt16 id)
 {
     switch (id) {
@@ -83,15 +89,6 @@ static const struct goodix_chip_data *goodix_get_chip_data(UInt16 id)
     }
 };
 
-/* Temp: Taken from the Linux kernel source */
-static inline uint16_t __get_unaligned_le16(const uint8_t *p) {
-    return p[0] | p[1] << 8;
-}
-
-static inline uint16_t get_unaligned_le16(const void *p) {
-    return __get_unaligned_le16((const uint8_t *)p);
-}
-
 /* This is supposed to be a sub for kstrtou16(), adapted from https://stackoverflow.com/a/20020795/1170723 */
 static inline bool str_to_uint16(const char *str, uint16_t *res) {
     char *end;
@@ -103,6 +100,22 @@ static inline bool str_to_uint16(const char *str, uint16_t *res) {
     return true;
 }
 
+static void set_statistic(OSDictionary* dict, const char* key, UInt64 value) {
+    OSNumber* number = OSNumber::withNumber(value, 64);
+    if (number) {
+        dict->setObject(key, number);
+        number->release();
+    }
+}
+
+static UInt64 get_uptime_ns() {
+    AbsoluteTime timestamp;
+    UInt64 nanoseconds;
+    clock_get_uptime(&timestamp);
+    absolutetime_to_nanoseconds(timestamp, &nanoseconds);
+    return nanoseconds;
+}
+
 static inline void swap(int& x, int& y) {
     int z = x;
     x = y;
@@ -114,10 +127,33 @@ bool VoodooI2CGoodixTouchDriver::init(OSDictionary *properties) {
         return false;
     }
 
-    numTouches = 0;
+    predicted_touch_num = 1;
+    polling = false;
+    polling_only = false;
+    consecutive_touch_frames = 0;
+    idle_polls = 0;
+    last_frame_ns = 0;
+    memset(mode_frames, 0, sizeof(mode_frames));
+    memset(mode_frame_ns, 0, sizeof(mode_frame_ns));
+    touch_active = false;
+    last_lift_ns = 0;
+    irq_timestamp_ns = 0;
+    ready_delay.reset();
+    ready_timestamp_ns = 0;
+    read_timestamp_ns = 0;
+    wake_latency.reset();
+    read_latency.reset();
+    memset(&stats, 0, sizeof(stats));
     awake = true;
     ready_for_input = false;
     read_in_progress = false;
+    reader_lock = NULL;
+    reader_pending = false;
+    reader_running = false;
+    reader_exiting = false;
+    trace_writer = NULL;
+    replay_trace = NULL;
+    panel_transform_changed = false;
     return true;
 }
 
@@ -151,6 +187,9 @@ bool VoodooI2CGoodixTouchDriver::start(IOService* provider) {
         return false;
     }
     bool event_driver_initialized = true;
+#ifndef GOODIX_SIMULATOR
+    OSBoolean* force_polling;
+#endif
     workLoop = this->getWorkLoop();
     if (!workLoop) {
         IOLog("%s::Could not get a IOWorkLoop instance\n", getName());
@@ -169,13 +208,34 @@ bool VoodooI2CGoodixTouchDriver::start(IOService* provider) {
         goto start_exit;
     }
 
-    // set interrupts AFTER device is initialised
-    interrupt_source = IOInterruptEventSource::interruptEventSource(this, OSMemberFunctionCast(IOInterruptEventAction, this, &VoodooI2CGoodixTouchDriver::interrupt_occurred), api, 0);
-    if (!interrupt_source) {
-        IOLog("%s::Could not get interrupt event source\n", getName());
+#ifdef GOODIX_SIMULATOR
+    transport = simulator = create_simulator();
+#else
+    transport = new VoodooI2CGoodixNubTransport(api);
+#endif
+    if (!transport) {
+        IOLog("%s::No memory to allocate transport\n", getName());
         goto start_exit;
     }
 
+#ifndef GOODIX_SIMULATOR
+    // Some boards have no usable GPIO interrupt, so they can be configured to poll instead
+    force_polling = OSDynamicCast(OSBoolean, getProperty("ForcePolling"));
+    if (force_polling && force_polling->isTrue()) {
+        IOLog("%s::Polling mode forced by configuration\n", getName());
+        polling_only = true;
+    }
+    else {
+        // set interrupts AFTER device is initialised
+        interrupt_source = IOInterruptEventSource::interruptEventSource(this, OSMemberFunctionCast(IOInterruptEventAction, this, &VoodooI2CGoodixTouchDriver::interrupt_occurred), api, 0);
+        if (!interrupt_source) {
+            IOLog("%s::Could not get interrupt event source, falling back to polling mode\n", getName());
+            polling_only = true;
+        }
+    }
+    polling = polling_only;
+#endif
+
     if (!init_device()) {
         IOLog("%s::Failed to init device\n", getName());
         goto start_exit;
@@ -183,15 +243,34 @@ bool VoodooI2CGoodixTouchDriver::start(IOService* provider) {
     else {
         IOLog("%s::Device initialized\n", getName());
     }
-    workLoop->addEventSource(interrupt_source);
-    interrupt_source->enable();
+
+    poll_timer = IOTimerEventSource::timerEventSource(this, OSMemberFunctionCast(IOTimerEventSource::Action, this, &VoodooI2CGoodixTouchDriver::poll_timer_fired));
+    if (!poll_timer || workLoop->addEventSource(poll_timer) != kIOReturnSuccess) {
+        IOLog("%s::Could not add poll timer source to work loop\n", getName());
+        goto start_exit;
+    }
+
+#ifdef GOODIX_SIMULATOR
+    simulator_timer = IOTimerEventSource::timerEventSource(this, OSMemberFunctionCast(IOTimerEventSource::Action, this, &VoodooI2CGoodixTouchDriver::simulator_timer_fired));
+    if (!simulator_timer || workLoop->addEventSource(simulator_timer) != kIOReturnSuccess) {
+        IOLog("%s::Could not add simulator timer source to work loop\n", getName());
+        goto start_exit;
+    }
+#endif
+
+    if (!start_reader_thread()) {
+        IOLog("%s::Could not start reader thread\n", getName());
+        goto start_exit;
+    }
+
+    if (interrupt_source) {
+        workLoop->addEventSource(interrupt_source);
+        interrupt_source->enable();
+    }
     PMinit();
     api->joinPMtree(this);
     registerPowerDriver(this, VoodooI2CIOPMPowerStates, kVoodooI2CIOPMNumberPowerStates);
     IOSleep(100);
-    ready_for_input = true;
-    setProperty("VoodooI2CServices Supported", OSBoolean::withBoolean(true));
-    IOLog("%s::VoodooI2CGoodixTouchDriver has started\n", getName());
 
     // Instantiate the event driver
     event_driver = OSTypeAlloc(VoodooI2CGoodixEventDriver);
@@ -215,6 +294,17 @@ bool VoodooI2CGoodixTouchDriver::start(IOService* provider) {
     event_driver->configureMultitouchInterface(ts->abs_x_max, ts->abs_y_max, GOODIX_MAX_CONTACTS, GOODIX_VENDOR_ID);
     event_driver->registerService();
 
+    // Reports are only read once there's an event driver to send them to
+    ready_for_input = true;
+    if (polling_only) {
+        poll_timer->setTimeoutMS(poll_interval_ms());
+    }
+#ifdef GOODIX_SIMULATOR
+    simulator_timer->setTimeoutMS(1);
+#endif
+    setProperty("VoodooI2CServices Supported", OSBoolean::withBoolean(true));
+    IOLog("%s::VoodooI2CGoodixTouchDriver has started\n", getName());
+
     registerService();
 
     return true;
@@ -224,36 +314,251 @@ start_exit:
 }
 
 void VoodooI2CGoodixTouchDriver::interrupt_occurred(OSObject* owner, IOInterruptEventSource* src, int intCount) {
-    if (read_in_progress || !awake) {
+    if (read_in_progress || !awake || reader_exiting) {
         return;
     }
-    interrupt_source->disable();
+    if (interrupt_source) {
+        interrupt_source->disable();
+    }
     read_in_progress = true;
+
+    AbsoluteTime timestamp;
+    clock_get_uptime(&timestamp);
+    absolutetime_to_nanoseconds(timestamp, &irq_timestamp_ns);
+
+    wake_reader();
+}
+
+bool VoodooI2CGoodixTouchDriver::start_reader_thread() {
+    reader_lock = IOLockAlloc();
+    if (!reader_lock) {
+        return false;
+    }
+
+    reader_pending = false;
+    reader_exiting = false;
+    reader_running = true;
+
+    // The reader thread lives as long as the driver, so we don't pay for a
+    // thread create/destroy on every frame
     thread_t new_thread;
-    kern_return_t ret = kernel_thread_start(OSMemberFunctionCast(thread_continue_t, this, &VoodooI2CGoodixTouchDriver::handle_input_threaded), this, &new_thread);
+    kern_return_t ret = kernel_thread_start(OSMemberFunctionCast(thread_continue_t, this, &VoodooI2CGoodixTouchDriver::reader_thread_main), this, &new_thread);
     if (ret != KERN_SUCCESS) {
-        read_in_progress = false;
-        interrupt_source->enable();
-        IOLog("%s::Thread error while attemping to get input report: %d\n", getName(), ret);
+        IOLog("%s::Thread error while attempting to start reader thread: %d\n", getName(), ret);
+        reader_running = false;
+        IOLockFree(reader_lock);
+        reader_lock = NULL;
+        return false;
     }
-    else {
-        thread_deallocate(new_thread);
+    thread_deallocate(new_thread);
+    return true;
+}
+
+void VoodooI2CGoodixTouchDriver::stop_reader_thread() {
+    if (!reader_lock) {
+        return;
     }
+
+    IOLockLock(reader_lock);
+    reader_exiting = true;
+    IOLockWakeup(reader_lock, &reader_pending, true);
+    while (reader_running) {
+        IOLockSleep(reader_lock, &reader_running, THREAD_UNINT);
+    }
+    IOLockUnlock(reader_lock);
+}
+
+void VoodooI2CGoodixTouchDriver::wake_reader() {
+    IOLockLock(reader_lock);
+    reader_pending = true;
+    IOLockWakeup(reader_lock, &reader_pending, true);
+    IOLockUnlock(reader_lock);
+}
+
+void VoodooI2CGoodixTouchDriver::reader_thread_main() {
+    IOLockLock(reader_lock);
+    while (!reader_exiting) {
+        // Only between reports, so a report is never transformed halfway through a change
+        if (panel_transform_changed) {
+            panel_transform = next_panel_transform;
+            panel_transform_changed = false;
+        }
+
+        // A replay holds off the panel until it's done, its reports are read afterwards
+        if (replay_trace) {
+            OSData* trace = replay_trace;
+            IOLockUnlock(reader_lock);
+            replay(trace);
+            IOLockLock(reader_lock);
+            trace->release();
+            replay_trace = NULL;
+            continue;
+        }
+
+        if (!reader_pending) {
+            IOLockSleep(reader_lock, &reader_pending, THREAD_UNINT);
+            continue;
+        }
+        reader_pending = false;
+
+        IOLockUnlock(reader_lock);
+        handle_input_threaded();
+        IOLockLock(reader_lock);
+    }
+
+    reader_running = false;
+    IOLockWakeup(reader_lock, &reader_running, true);
+    IOLockUnlock(reader_lock);
+
+    thread_terminate(current_thread());
+}
+
+void VoodooI2CGoodixTouchDriver::reader_sleep_until(UInt64 deadline_ns) {
+    AbsoluteTime deadline;
+    nanoseconds_to_absolutetime(deadline_ns, &deadline);
+
+    // Nothing wakes this event, so we sleep until the deadline with sub-millisecond precision
+    IOLockLock(reader_lock);
+    IOLockSleepDeadline(reader_lock, &irq_timestamp_ns, deadline, THREAD_UNINT);
+    IOLockUnlock(reader_lock);
 }
 
 void VoodooI2CGoodixTouchDriver::handle_input_threaded() {
     if (!ready_for_input || !command_gate) {
-        read_in_progress = false;
+        rearm_interrupt();
         return;
     }
-    command_gate->attemptAction(OSMemberFunctionCast(IOCommandGate::Action, this, &VoodooI2CGoodixTouchDriver::goodix_process_events));
-    goodix_end_cmd();
-    interrupt_source->enable();
+
+    // goodix_process_events re-arms the interrupt itself as soon as the report is read
+    goodix_process_events();
+}
+
+void VoodooI2CGoodixTouchDriver::rearm_interrupt() {
     read_in_progress = false;
+    if (!polling && interrupt_source) {
+        interrupt_source->enable();
+    }
+}
+
+void VoodooI2CGoodixTouchDriver::poll_timer_fired(OSObject* owner, IOTimerEventSource* timer) {
+    if (!polling || reader_exiting) {
+        return;
+    }
+
+    // Re-arm first so the polling cadence doesn't drift with the reader
+    poll_timer->setTimeoutMS(poll_interval_ms());
+
+    if (read_in_progress || !awake) {
+        return;
+    }
+    read_in_progress = true;
+
+    AbsoluteTime timestamp;
+    clock_get_uptime(&timestamp);
+    absolutetime_to_nanoseconds(timestamp, &irq_timestamp_ns);
+
+    wake_reader();
+}
+
+#ifdef GOODIX_SIMULATOR
+static UInt64 simulator_clock(void* ref) {
+    return get_uptime_ns();
+}
+
+VoodooI2CGoodixSimulator* VoodooI2CGoodixTouchDriver::create_simulator() {
+    VoodooI2CGoodixSimulator* simulator = new VoodooI2CGoodixSimulator(simulator_clock, NULL);
+    if (!simulator) {
+        return NULL;
+    }
+
+    simulator->configure(911, 0x1060, GOODIX_GT9X_REG_CONFIG_DATA, GOODIX_CONFIG_911_LENGTH, 1280, 800, GOODIX_MAX_CONTACTS, 5);
+
+    // Drag a finger across the screen, lift it, then raise the spurious interrupts a real panel would
+    VoodooI2CGoodixSimulatedContact contact = {0, 0, 400, 20, false};
+    UInt64 at = 0;
+    for (int i = 0; i < 100; i++, at += 10000000) {
+        contact.x = 140 + i * 10;
+        simulator->scriptFrame(at, &contact, 1);
+    }
+    simulator->scriptFrame(at, NULL, 0);
+    simulator->scriptSpuriousInterrupt(at + 5000000);
+    simulator->scriptSpuriousInterrupt(at + 15000000);
+    simulator->setLoop(2000000000);
+
+    IOLog("%s::Using simulated panel\n", getName());
+    return simulator;
+}
+
+void VoodooI2CGoodixTouchDriver::simulator_timer_fired(OSObject* owner, IOTimerEventSource* timer) {
+    if (reader_exiting) {
+        return;
+    }
+    simulator_timer->setTimeoutMS(1);
+
+    // The interrupt is masked while polling, like the real one
+    if (simulator->takeInterrupt() && !polling) {
+        interrupt_occurred(this, NULL, 0);
+    }
+}
+#endif
+
+UInt32 VoodooI2CGoodixTouchDriver::poll_interval_ms() {
+    // Without an interrupt to wake us, poll slowly until something touches the screen,
+    // and slower still the longer nothing does
+    if (polling_only && !touch_active) {
+        UInt32 interval = GOODIX_IDLE_POLL_INTERVAL;
+        for (int run = idle_polls; run >= GOODIX_IDLE_POLL_BACKOFF && interval < GOODIX_IDLE_POLL_INTERVAL_MAX; run -= GOODIX_IDLE_POLL_BACKOFF) {
+            interval *= 2;
+        }
+        return interval < GOODIX_IDLE_POLL_INTERVAL_MAX ? interval : GOODIX_IDLE_POLL_INTERVAL_MAX;
+    }
+    return ts->refresh_interval_ms;
+}
+
+void VoodooI2CGoodixTouchDriver::update_report_mode(int touch_num) {
+    if (touch_num > 0) {
+        consecutive_touch_frames++;
+        idle_polls = 0;
+    }
+    else {
+        consecutive_touch_frames = 0;
+        if (touch_num == GOODIX_REPORT_NOT_READY) {
+            idle_polls++;
+        }
+    }
+
+    if (polling_only) {
+        // If we lost the lift report, stop polling at the full rate
+        if (idle_polls >= GOODIX_POLL_IDLE_LIMIT) {
+            touch_active = false;
+        }
+    }
+    else if (!polling && consecutive_touch_frames >= GOODIX_POLL_SWITCH_FRAMES) {
+        // The interrupt source stays disabled until we switch back
+        polling = true;
+        idle_polls = 0;
+        stats.mode_switches++;
+        poll_timer->setTimeoutMS(ts->refresh_interval_ms);
+    }
+    else if (polling && (touch_num == 0 || idle_polls >= GOODIX_POLL_IDLE_LIMIT)) {
+        // The touches ended, or we lost the lift report
+        polling = false;
+        stats.mode_switches++;
+        poll_timer->cancelTimeout();
+    }
+}
+
+void VoodooI2CGoodixTouchDriver::account_frame() {
+    // Only count frames that belong to the same burst of touches
+    if (last_frame_ns && irq_timestamp_ns - last_frame_ns < GOODIX_FRAME_RATE_MAX_GAP) {
+        mode_frames[polling]++;
+        mode_frame_ns[polling] += irq_timestamp_ns - last_frame_ns;
+    }
+    last_frame_ns = irq_timestamp_ns;
 }
 
 IOReturn VoodooI2CGoodixTouchDriver::goodix_end_cmd() {
-    IOReturn retVal = goodix_write_reg(GOODIX_READ_COOR_ADDR, 0);
+    IOReturn retVal = transport->endCmd();
     if (retVal != kIOReturnSuccess) {
         IOLog("%s::I2C write end_cmd 0 error: %d\n", getName(), retVal);
     }
@@ -263,121 +568,164 @@ IOReturn VoodooI2CGoodixTouchDriver::goodix_end_cmd() {
 /* Ported from goodix.c */
 IOReturn VoodooI2CGoodixTouchDriver::goodix_process_events() {
     // Allocate enough space for the status byte, all touches, and the extra button byte
-    UInt8 data[1 + GOODIX_CONTACT_SIZE * GOODIX_MAX_CONTACTS + 1];
+    UInt8 data[GOODIX_REPORT_MAX_LENGTH];
 
-    numTouches = goodix_ts_read_input_report(data);
-    if (numTouches <= 0) {
-        return kIOReturnSuccess;
-    }
+    wake_latency.record((get_uptime_ns() - irq_timestamp_ns) / 1000);
+
+    /*
+     * The bus transfers happen outside of the command gate, so the event driver
+     * can report the previous frame on the work loop while we read this one.
+     */
+    int touch_num = goodix_ts_read_input_report(data);
 
-    UInt8 keys = data[1 + numTouches * GOODIX_CONTACT_SIZE];
-    if (GOODIX_KEYDOWN_EVENT(keys)) {
-        stylusButton1 = GOODIX_IS_STYLUS_BTN_DOWN(keys, GOODIX_STYLUS_BTN1);
-        stylusButton2 = GOODIX_IS_STYLUS_BTN_DOWN(keys, GOODIX_STYLUS_BTN2);
+    /*
+     * Acknowledge the report as soon as it has been read and let the next
+     * interrupt in, so the panel prepares the next frame while we process this one.
+     * Like goodix.c, this is done even if the buffer never became ready, so a
+     * report that became ready after the last check can't leave the panel
+     * waiting for an acknowledgement that never comes. A poll that found no
+     * buffer has nothing to acknowledge, the next poll reads a late report.
+     */
+    if (touch_num != GOODIX_REPORT_NOT_READY || !polling) {
+        goodix_end_cmd();
     }
-    else {
-        stylusButton1 = false;
-        stylusButton2 = false;
+    command_gate->runAction(OSMemberFunctionCast(IOCommandGate::Action, this, &VoodooI2CGoodixTouchDriver::finish_read), &touch_num, data);
+
+    // Reports without contacts are forwarded too, they tell the event driver the fingers lifted
+    if (touch_num < 0) {
+        return kIOReturnSuccess;
     }
 
-    UInt8 *point_data;
-    for (int i = 0; i < numTouches; i++) {
-        point_data = &data[1 + i * GOODIX_CONTACT_SIZE];
-        goodix_ts_store_touch(point_data);
+    goodix_ts_report_frame(data, touch_num, irq_timestamp_ns, read_timestamp_ns);
+    return kIOReturnSuccess;
+}
+
+bool VoodooI2CGoodixTouchDriver::goodix_ts_report_frame(UInt8 *data, int touch_num, UInt64 timestamp, UInt64 read_timestamp) {
+    TouchFrame frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.timestamp = timestamp;
+    frame.readTimestamp = read_timestamp;
+
+    goodix_decode_report(data, touch_num, panel_transform, &frame);
+    for (int i = 0; i < frame.numTouches; i++) {
+        const Touch& touch = frame.touches[i];
+        tracepoints.record(kGoodixTraceCategoryContact, touch.type ? kGoodixTraceStylusContact : kGoodixTraceFingerContact, touch.id, touch.width, touch.x, touch.y);
     }
 
-    if (numTouches > 0) {
-        // send the event into the event driver
-        event_driver->reportTouches(touches, numTouches, stylusButton1, stylusButton2);
+    // Every contact had a track ID we can't follow, so there's nothing to report
+    if (touch_num > 0 && !frame.numTouches) {
+        return true;
     }
 
+    // send the frame to the event driver
+    return event_driver->enqueueFrame(frame);
+}
+
+IOReturn VoodooI2CGoodixTouchDriver::finish_read(int* touch_num, UInt8* data) {
+    // The poll timer shares this state, so it's only changed on the work loop
+    if (*touch_num >= 0) {
+        account_frame();
+        if (trace_writer) {
+            trace_writer->append(irq_timestamp_ns, data, 1 + GOODIX_CONTACT_SIZE * *touch_num + 1);
+        }
+    }
+    update_report_mode(*touch_num);
+    rearm_interrupt();
     return kIOReturnSuccess;
 }
 
 /* Ported from goodix.c */
 int VoodooI2CGoodixTouchDriver::goodix_ts_read_input_report(UInt8 *data) {
     uint64_t max_timeout;
+    uint64_t poll_interval = GOODIX_POLL_INTERVAL;
     int touch_num;
-    IOReturn retVal;
 
     AbsoluteTime timestamp;
     uint64_t timestamp_ns;
-    clock_get_uptime(&timestamp);
-    absolutetime_to_nanoseconds(timestamp, &timestamp_ns);
 
     /*
      * The 'buffer status' bit, which indicates that the data is valid, is
      * not set as soon as the interrupt is raised, but slightly after.
      * This takes around 10 ms to happen, so we poll for GOODIX_BUFFER_STATUS_TIMEOUT (20ms).
      */
-    max_timeout = timestamp_ns + GOODIX_BUFFER_STATUS_TIMEOUT;
+    max_timeout = irq_timestamp_ns + GOODIX_BUFFER_STATUS_TIMEOUT;
+
+    /*
+     * The Goodix panel will send spurious interrupts after a 'finger up' event,
+     * which would always cause a timeout with the interrupt source disabled.
+     * Shortly after a lift, don't check the status until the bit is almost
+     * always set for a real report, then poll coarsely for the rest of the wait.
+     * Giving up there would acknowledge a real report that's just late, and
+     * lose the first tap of a fast double tap.
+     */
+    bool learned = ready_delay.count() >= GOODIX_READY_DELAY_MIN_SAMPLES;
+    bool may_be_spurious = !polling && learned && !touch_active && irq_timestamp_ns - last_lift_ns < GOODIX_SPURIOUS_IRQ_WINDOW;
+
+    /*
+     * Once we've learned how long this panel usually takes, sleep through
+     * the part of the wait where the bit is almost never set, then poll finely.
+     */
+    if (may_be_spurious) {
+        reader_sleep_until(irq_timestamp_ns + ready_delay.percentile(GOODIX_SPURIOUS_IRQ_PERCENTILE) * 1000);
+    }
+    else if (learned && !polling) {
+        reader_sleep_until(irq_timestamp_ns + ready_delay.percentileFloor(GOODIX_READY_DELAY_PERCENTILE) * 1000);
+        poll_interval = GOODIX_POLL_INTERVAL_FINE;
+    }
+
     do {
         clock_get_uptime(&timestamp);
         absolutetime_to_nanoseconds(timestamp, &timestamp_ns);
 
-        // On the intial read, get the status byte, the first touch, and the pen buttons
-        retVal = goodix_read_reg(GOODIX_READ_COOR_ADDR, data, 1 + GOODIX_CONTACT_SIZE + 1);
-        if (retVal != kIOReturnSuccess) {
-            IOLog("%s::I2C transfer error starting coordinate read: %d\n", getName(), retVal);
-            return -1;
+        touch_num = goodix_read_report(transport, data, predicted_touch_num, ts->max_touch_num);
+        if (touch_num == GOODIX_REPORT_ERROR) {
+            IOLog("%s::I2C transfer error during coordinate read\n", getName());
+            return GOODIX_REPORT_ERROR;
+        }
+        if (touch_num == GOODIX_REPORT_INVALID) {
+            IOLog("%s::Error: got more touches than we should have (max = %d)\n", getName(), ts->max_touch_num);
+            return GOODIX_REPORT_ERROR;
         }
-        if (data[0] & GOODIX_BUFFER_STATUS_READY) {
-            touch_num = data[0] & 0x0f;
-            if (touch_num > ts->max_touch_num) {
-                IOLog("%s::Error: got more touches than we should have (got %d, max = %d)\n", getName(), touch_num, ts->max_touch_num);
-                return -1;
+        if (touch_num != GOODIX_REPORT_NOT_READY) {
+            ready_timestamp_ns = timestamp_ns;
+            if (!polling) {
+                ready_delay.record((timestamp_ns - irq_timestamp_ns) / 1000);
             }
 
-            if (touch_num > 1) {
-                data += 1 + GOODIX_CONTACT_SIZE;
-                // Read all touches, and 1 additional byte for the pen buttons
-                retVal = goodix_read_reg(GOODIX_READ_COOR_ADDR + 1 + GOODIX_CONTACT_SIZE, data, GOODIX_CONTACT_SIZE * (touch_num - 1) + 1);
-                if (retVal != kIOReturnSuccess) {
-                    IOLog("%s::I2C transfer error during coordinate read: %d\n", getName(), retVal);
-                    return -1;
-                }
+            if (touch_num > predicted_touch_num) {
+                stats.read_misses++;
+            }
+            else {
+                stats.read_hits++;
             }
 
-            return touch_num;
-        }
+            read_timestamp_ns = get_uptime_ns();
+            read_latency.record((read_timestamp_ns - ready_timestamp_ns) / 1000);
 
-        usleep_range(1000, 2000); /* Poll every 1 - 2 ms */
-    } while (timestamp_ns < max_timeout);
+            predicted_touch_num = touch_num > 0 ? touch_num : 1;
 
-    /*
-     * The Goodix panel will send spurious interrupts after a
-     * 'finger up' event, which will always cause a timeout.
-     */
-    return 0;
-}
+            touch_active = touch_num > 0;
+            if (!touch_active) {
+                last_lift_ns = timestamp_ns;
+            }
 
-/* Ported from goodix.c */
-void VoodooI2CGoodixTouchDriver::goodix_ts_store_touch(UInt8 *coor_data) {
-    int id = coor_data[0] & 0x0F;
-    int input_x = get_unaligned_le16(&coor_data[1]);
-    int input_y = get_unaligned_le16(&coor_data[3]);
-    int input_w = get_unaligned_le16(&coor_data[5]);
-    bool type = GOODIX_TOOL_TYPE(coor_data[0]) == GOODIX_TOOL_PEN;
-
-    // Inversions have to happen before axis swapping
-    if (ts->inverted_x)
-        input_x = ts->abs_x_max - input_x;
-    if (ts->inverted_y)
-        input_y = ts->abs_y_max - input_y;
+            return touch_num;
+        }
 
-    if (ts->swapped_x_y) {
-        swap(input_x, input_y);
-    }
+        // When polling, the next tick of the timer is our next chance
+        if (polling) {
+            return GOODIX_REPORT_NOT_READY;
+        }
 
-    #ifdef GOODIX_TOUCH_DRIVER_DEBUG
-    IOLog("%s::%s %d with width %d at %d,%d\n", getName(), type ? "Stylus" : "Touch", id, input_w, input_x, input_y);
-    #endif
+        stats.status_polls++;
+        reader_sleep_until(timestamp_ns + poll_interval * 1000);
+    } while (timestamp_ns < max_timeout);
 
-    // Store touch information
-    touches[id].x = input_x;
-    touches[id].y = input_y;
-    touches[id].width = input_w;
-    touches[id].type = type;
+    // Spurious interrupts end up here
+    if (may_be_spurious) {
+        stats.spurious_irqs++;
+    }
+    return GOODIX_REPORT_NOT_READY;
 }
 
 void VoodooI2CGoodixTouchDriver::stop(IOService* provider) {
@@ -388,6 +736,196 @@ void VoodooI2CGoodixTouchDriver::stop(IOService* provider) {
     super::stop(provider);
 }
 
+bool VoodooI2CGoodixTouchDriver::serializeProperties(OSSerialize* s) const {
+    const_cast<VoodooI2CGoodixTouchDriver*>(this)->publish_statistics();
+    return super::serializeProperties(s);
+}
+
+void VoodooI2CGoodixTouchDriver::publish_statistics() {
+    OSDictionary* statistics = OSDictionary::withCapacity(2);
+    if (!statistics) {
+        return;
+    }
+
+    set_statistic(statistics, "Speculative Read Hits", stats.read_hits);
+    set_statistic(statistics, "Speculative Read Misses", stats.read_misses);
+    set_statistic(statistics, "Status Polls", stats.status_polls);
+    set_statistic(statistics, "Spurious Interrupts After Lift", stats.spurious_irqs);
+    set_statistic(statistics, "Mode Switches", stats.mode_switches);
+    set_statistic(statistics, "Interrupt Mode Frame Rate (Hz)", mode_frame_ns[0] ? mode_frames[0] * 1000000000ULL / mode_frame_ns[0] : 0);
+    set_statistic(statistics, "Polling Mode Frame Rate (Hz)", mode_frame_ns[1] ? mode_frames[1] * 1000000000ULL / mode_frame_ns[1] : 0);
+    wake_latency.publish(statistics, "Wake Latency");
+    ready_delay.publish(statistics, "Ready Latency");
+    read_latency.publish(statistics, "Read Latency");
+    set_statistic(statistics, "Replayed Frames", stats.replay_frames);
+    set_statistic(statistics, "Replay Frame Rate (Hz)", stats.replay_ns ? stats.replay_frames * 1000000000ULL / stats.replay_ns : 0);
+
+    setProperty("Statistics", statistics);
+    statistics->release();
+}
+
+IOReturn VoodooI2CGoodixTouchDriver::setProperties(OSObject* properties) {
+    OSDictionary* dict = OSDynamicCast(OSDictionary, properties);
+    if (!dict) {
+        return kIOReturnBadArgument;
+    }
+
+    OSBoolean* record = OSDynamicCast(OSBoolean, dict->getObject("TraceRecord"));
+    OSData* trace = OSDynamicCast(OSData, dict->getObject("TraceReplay"));
+    OSNumber* categories = OSDynamicCast(OSNumber, dict->getObject("TraceCategories"));
+    OSBoolean* dump = OSDynamicCast(OSBoolean, dict->getObject("TraceDump"));
+    OSDictionary* calibration = OSDynamicCast(OSDictionary, dict->getObject("Calibration"));
+    OSBoolean* coalesce = OSDynamicCast(OSBoolean, dict->getObject("CoalesceFrames"));
+    if (!record && !trace && !categories && !dump && !calibration && !coalesce) {
+        return super::setProperties(properties);
+    }
+
+    // Traces record and inject input, and the rest change how it's reported, so only an administrator can set them
+    if (IOUserClient::clientHasPrivilege(current_task(), kIOClientPrivilegeAdministrator) != kIOReturnSuccess) {
+        return kIOReturnNotPrivileged;
+    }
+    if (!ready_for_input || !event_driver) {
+        return kIOReturnNotReady;
+    }
+
+    // Tracepoints are set for both drivers at once, so they can be lined up by their timestamps
+    if (categories) {
+        tracepoints.setCategories(categories->unsigned32BitValue());
+        event_driver->setTraceCategories(categories->unsigned32BitValue());
+    }
+    if (dump && dump->isTrue()) {
+        tracepoints.dump(getName());
+        event_driver->dumpTracepoints();
+    }
+
+    if (calibration) {
+        IOReturn ret = set_panel_transform(calibration);
+        if (ret != kIOReturnSuccess) {
+            return ret;
+        }
+        setProperty("Calibration", calibration);
+    }
+
+    if (coalesce) {
+        event_driver->setCoalescing(coalesce->isTrue());
+        setProperty("CoalesceFrames", coalesce);
+    }
+
+    if (record) {
+        command_gate->runAction(OSMemberFunctionCast(IOCommandGate::Action, this, &VoodooI2CGoodixTouchDriver::set_trace_recording), record);
+    }
+
+    if (trace) {
+        VoodooI2CGoodixTraceReader reader((const UInt8*)trace->getBytesNoCopy(), trace->getLength());
+        if (!reader.isValid()) {
+            IOLog("%s::Not replaying a trace with an unknown format\n", getName());
+            return kIOReturnBadArgument;
+        }
+
+        // The reader thread is the only producer of frames, so it plays the trace
+        IOLockLock(reader_lock);
+        if (replay_trace) {
+            IOLockUnlock(reader_lock);
+            return kIOReturnBusy;
+        }
+        trace->retain();
+        replay_trace = trace;
+        IOLockWakeup(reader_lock, &reader_pending, true);
+        IOLockUnlock(reader_lock);
+    }
+
+    return kIOReturnSuccess;
+}
+
+IOReturn VoodooI2CGoodixTouchDriver::set_trace_recording(OSBoolean* enable) {
+    if (enable->isTrue()) {
+        if (!trace_writer) {
+            trace_writer = new VoodooI2CGoodixTraceWriter;
+            if (!trace_writer || !trace_writer->start()) {
+                IOLog("%s::Could not allocate trace buffer\n", getName());
+                delete trace_writer;
+                trace_writer = NULL;
+                return kIOReturnNoMemory;
+            }
+            IOLog("%s::Recording trace\n", getName());
+        }
+        return kIOReturnSuccess;
+    }
+
+    if (!trace_writer) {
+        return kIOReturnSuccess;
+    }
+
+    IOLog("%s::Recorded %u reports, %u did not fit\n", getName(), trace_writer->getRecords(), trace_writer->getDroppedRecords());
+    OSData* trace = trace_writer->finish();
+    delete trace_writer;
+    trace_writer = NULL;
+
+    if (trace) {
+        setProperty("Trace", trace);
+        trace->release();
+    }
+    return kIOReturnSuccess;
+}
+
+void VoodooI2CGoodixTouchDriver::wait_for_event_driver(UInt32 max_queued) {
+    AbsoluteTime timestamp;
+    UInt64 now_ns;
+    while (event_driver->queuedFrames() > max_queued && !reader_exiting) {
+        clock_get_uptime(&timestamp);
+        absolutetime_to_nanoseconds(timestamp, &now_ns);
+        reader_sleep_until(now_ns + GOODIX_POLL_INTERVAL_FINE * 1000);
+    }
+}
+
+void VoodooI2CGoodixTouchDriver::replay(OSData* trace) {
+    VoodooI2CGoodixTraceReader reader((const UInt8*)trace->getBytesNoCopy(), trace->getLength());
+    VoodooI2CGoodixTraceRecord record;
+    UInt64 frames = 0;
+    bool replaying = false;
+
+    AbsoluteTime timestamp;
+    UInt64 start_ns, now_ns;
+    clock_get_uptime(&timestamp);
+    absolutetime_to_nanoseconds(timestamp, &start_ns);
+
+    while (!reader_exiting && reader.next(record)) {
+        // The event driver reports the frames on a virtual clock that follows their recorded timestamps,
+        // so the gestures and timers see the trace's timing however fast it's replayed
+        if (!replaying) {
+            wait_for_event_driver(0);
+            event_driver->beginReplay(record.timestamp);
+            replaying = true;
+        }
+
+        int touch_num = record.report[0] & 0x0f;
+
+        // Rather than dropping frames, wait for the event driver to make room for them
+        wait_for_event_driver(GOODIX_FRAME_RING_SIZE - 1);
+
+        if (goodix_ts_report_frame(record.report, touch_num, record.timestamp, 0)) {
+            frames++;
+        }
+    }
+
+    if (replaying) {
+        wait_for_event_driver(0);
+        event_driver->endReplay();
+    }
+
+    clock_get_uptime(&timestamp);
+    absolutetime_to_nanoseconds(timestamp, &now_ns);
+    stats.replay_frames = frames;
+    stats.replay_ns = now_ns - start_ns;
+
+    if (reader.isValid()) {
+        IOLog("%s::Replayed %llu frames in %llu us\n", getName(), frames, stats.replay_ns / 1000);
+    }
+    else {
+        IOLog("%s::Replayed %llu frames, then stopped at a malformed record\n", getName(), frames);
+    }
+}
+
 IOReturn VoodooI2CGoodixTouchDriver::setPowerState(unsigned long whichState, IOService* whatDevice) {
     if (whichState == 0) {
         if (awake) {
@@ -410,17 +948,46 @@ IOReturn VoodooI2CGoodixTouchDriver::setPowerState(unsigned long whichState, IOS
 }
 
 void VoodooI2CGoodixTouchDriver::release_resources() {
+    // Let any in-flight read finish before tearing down what it uses
+    stop_reader_thread();
+    if (replay_trace) {
+        replay_trace->release();
+        replay_trace = NULL;
+    }
+    if (trace_writer) {
+        delete trace_writer;
+        trace_writer = NULL;
+    }
     if (command_gate) {
         workLoop->removeEventSource(command_gate);
         command_gate->release();
         command_gate = NULL;
     }
+#ifdef GOODIX_SIMULATOR
+    if (simulator_timer) {
+        simulator_timer->cancelTimeout();
+        workLoop->removeEventSource(simulator_timer);
+        simulator_timer->release();
+        simulator_timer = NULL;
+    }
+#endif
+    if (poll_timer) {
+        polling = false;
+        poll_timer->cancelTimeout();
+        workLoop->removeEventSource(poll_timer);
+        poll_timer->release();
+        poll_timer = NULL;
+    }
     if (interrupt_source) {
         interrupt_source->disable();
         workLoop->removeEventSource(interrupt_source);
         interrupt_source->release();
         interrupt_source = NULL;
     }
+    if (reader_lock) {
+        IOLockFree(reader_lock);
+        reader_lock = NULL;
+    }
     if (workLoop) {
         workLoop->release();
         workLoop = NULL;
@@ -429,6 +996,13 @@ void VoodooI2CGoodixTouchDriver::release_resources() {
         acpi_device->release();
         acpi_device = NULL;
     }
+    if (transport) {
+        delete transport;
+        transport = NULL;
+#ifdef GOODIX_SIMULATOR
+        simulator = NULL;
+#endif
+    }
     if (api) {
         if (api->isOpen(this)) {
             api->close(this);
@@ -443,27 +1017,6 @@ void VoodooI2CGoodixTouchDriver::release_resources() {
     }
 }
 
-/* Adapted from the TFE Driver */
-IOReturn VoodooI2CGoodixTouchDriver::goodix_read_reg(UInt16 reg, UInt8* values, size_t len) {
-    IOReturn retVal = kIOReturnSuccess;
-    UInt16 buffer[] {
-        OSSwapHostToBigInt16(reg)
-    };
-    retVal = api->writeReadI2C(reinterpret_cast<UInt8*>(&buffer), sizeof(buffer), values, len);
-    return retVal;
-}
-
-/* Adapted from the TFE Driver */
-IOReturn VoodooI2CGoodixTouchDriver::goodix_write_reg(UInt16 reg, UInt8 value) {
-    UInt16 buffer[] {
-        OSSwapHostToBigInt16(reg),
-        value
-    };
-    IOReturn retVal = kIOReturnSuccess;
-    retVal = api->writeI2C(reinterpret_cast<UInt8*>(&buffer), sizeof(buffer));
-    return retVal;
-}
-
 /* Ported from goodix.c */
 IOReturn VoodooI2CGoodixTouchDriver::goodix_read_version() {
     IOLog("%s::Reading version...\n", getName());
@@ -473,7 +1026,7 @@ IOReturn VoodooI2CGoodixTouchDriver::goodix_read_version() {
     char id_str[5];
 
     // AtmelMTX method
-    retVal = goodix_read_reg(GOODIX_REG_ID, buf, sizeof(buf));
+    retVal = transport->readVersion(buf, sizeof(buf));
     if (retVal != kIOReturnSuccess) {
         IOLog("%s::Read version failed: %d\n", getName(), retVal);
         return retVal;
@@ -503,7 +1056,7 @@ void VoodooI2CGoodixTouchDriver::goodix_read_config() {
     UInt8 config[GOODIX_CONFIG_MAX_LENGTH];
     IOReturn retVal = kIOReturnSuccess;
 
-    retVal = goodix_read_reg(ts->chip->config_addr, config, ts->chip->config_len);
+    retVal = transport->readConfig(ts->chip->config_addr, config, ts->chip->config_len);
     if (retVal != kIOReturnSuccess) {
         IOLog("%s::Error reading config (%d), using defaults\n", getName(), retVal);
     }
@@ -537,6 +1090,7 @@ void VoodooI2CGoodixTouchDriver::goodix_read_config() {
     UInt8 screenLeaveLevel = config[LEAVE_LEVEL_LOC];
     UInt8 lowPowerInterval = config[LOW_POWER_INTERVAL_LOC] & 0x0f;
     UInt8 refreshRate = config[REFRESH_LOC] & 0x0f;
+    ts->refresh_interval_ms = GOODIX_REFRESH_INTERVAL(refreshRate);
     UInt8 xThreshold = config[X_THRESHOLD_LOC];
     UInt8 yThreshold = config[Y_THRESHOLD_LOC];
 
@@ -557,6 +1111,7 @@ void VoodooI2CGoodixTouchDriver::set_default_config() {
     if (ts->swapped_x_y)
         swap(ts->abs_x_max, ts->abs_y_max);
     ts->max_touch_num = GOODIX_MAX_CONTACTS;
+    ts->refresh_interval_ms = GOODIX_DEFAULT_REFRESH_INTERVAL;
 }
 
 UInt8 VoodooI2CGoodixTouchDriver::goodix_calculate_config_checksum(UInt8 config[]) {
@@ -579,15 +1134,60 @@ IOReturn VoodooI2CGoodixTouchDriver::goodix_check_config(UInt8 config[]) {
     return kIOReturnSuccess;
 }
 
+IOReturn VoodooI2CGoodixTouchDriver::set_panel_transform(OSDictionary* calibration) {
+    // Inversions have to happen before axis swapping, on the panel's own axes, which the config already swapped the maxima of
+    int raw_x_max = ts->swapped_x_y ? ts->abs_y_max : ts->abs_x_max;
+    int raw_y_max = ts->swapped_x_y ? ts->abs_x_max : ts->abs_y_max;
+    VoodooI2CGoodixTransform transform = VoodooI2CGoodixTransform::invert(ts->inverted_x, ts->inverted_y, raw_x_max, raw_y_max);
+    if (ts->swapped_x_y) {
+        transform = transform.then(VoodooI2CGoodixTransform::swapAxes());
+    }
+
+    if (calibration) {
+        // The linear part is 16.16 fixed point, limited so a report's coordinates can't overflow it
+        static const char* const keys[] = {"ScaleX", "SkewX", "SkewY", "ScaleY", "OffsetX", "OffsetY"};
+        static const SInt32 defaults[] = {0x10000, 0, 0, 0x10000, 0, 0};
+        static const SInt32 limits[] = {0x100000, 0x100000, 0x100000, 0x100000, 0xFFFF, 0xFFFF};
+        SInt32 values[6];
+        for (int i = 0; i < 6; i++) {
+            OSNumber* number = OSDynamicCast(OSNumber, calibration->getObject(keys[i]));
+            values[i] = number ? (SInt32)number->unsigned32BitValue() : defaults[i];
+            if (values[i] > limits[i] || values[i] < -limits[i]) {
+                return kIOReturnBadArgument;
+            }
+        }
+        transform = transform.then(VoodooI2CGoodixTransform::calibration(values[0], values[1], values[2], values[3], values[4], values[5]));
+    }
+
+    // A calibration can move contacts off the panel, the multitouch interface only takes them on it
+    transform = transform.clampedTo(ts->abs_x_max, ts->abs_y_max);
+
+    // Before the reader thread starts there's no one to hand it to
+    if (!reader_lock) {
+        panel_transform = transform;
+        return kIOReturnSuccess;
+    }
+    IOLockLock(reader_lock);
+    next_panel_transform = transform;
+    panel_transform_changed = true;
+    IOLockUnlock(reader_lock);
+    return kIOReturnSuccess;
+}
+
 IOReturn VoodooI2CGoodixTouchDriver::goodix_configure_dev() {
     IOReturn retVal = kIOReturnSuccess;
 
-    ts->swapped_x_y = false;
-    ts->inverted_x = false;
-    ts->inverted_y = false;
+    ts->swapped_x_y = get_bool_property(this, "SwappedXY");
+    ts->inverted_x = get_bool_property(this, "InvertedX");
+    ts->inverted_y = get_bool_property(this, "InvertedY");
 
     goodix_read_config();
 
+    if (set_panel_transform(OSDynamicCast(OSDictionary, getProperty("Calibration"))) != kIOReturnSuccess) {
+        IOLog("%s::Ignoring out of range calibration\n", getName());
+        set_panel_transform(NULL);
+    }
+
     return retVal;
 }
 
@@ -15,16 +15,28 @@
 #include "../../../Multitouch Support/VoodooI2CMultitouchInterface.hpp"
 #include "../../../Multitouch Support/MultitouchHelpers.hpp"
 #include "../../../Dependencies/helpers.hpp"
+#include <IOKit/IOTimerEventSource.h>
 #include "./VoodooI2CGoodixEventDriver.hpp"
+#include "./VoodooI2CGoodixLatencyHistogram.hpp"
+#include "./VoodooI2CGoodixNubTransport.hpp"
+#include "./VoodooI2CGoodixTrace.hpp"
+#include "./VoodooI2CGoodixTracepoints.hpp"
+#include "./VoodooI2CGoodixTransform.hpp"
 #include "goodix.h"
 
-//#define GOODIX_TOUCH_DRIVER_DEBUG
+// Replace the panel with a simulated one that plays a scripted drag in a loop
+//#define GOODIX_SIMULATOR
+
+#ifdef GOODIX_SIMULATOR
+#include "./VoodooI2CGoodixSimulator.hpp"
+#endif
 
 class VoodooI2CGoodixTouchDriver : public IOService {
     OSDeclareDefaultStructors(VoodooI2CGoodixTouchDriver);
 
     VoodooI2CDeviceNub *api;
     IOACPIPlatformDevice *acpi_device;
+    VoodooI2CGoodixTransport *transport;
 public:
     /* Initialises the VoodooI2CGoodixTouchDriver object/instance (intended as IOKit driver ctor)
      *
@@ -50,6 +62,19 @@ public:
      *
      */
     void stop(IOService* provider) override;
+
+    /* Refreshes the published statistics before the registry is read
+     */
+    bool serializeProperties(OSSerialize* s) const override;
+
+    /* Starts or stops trace recording with "TraceRecord", replays the trace passed as "TraceReplay",
+     * enables tracepoints by category with "TraceCategories", logs them with "TraceDump", and
+     * applies a new "Calibration"
+     *
+     * @return kIOReturnSuccess if the properties were handled, kIOReturnNotPrivileged if any of
+     *  these is set by a task that isn't running as an administrator
+     */
+    IOReturn setProperties(OSObject* properties) override;
     
 protected:
     IOReturn setPowerState(unsigned long powerState, IOService* whatDevice) override;
@@ -64,12 +89,71 @@ private:
     IOCommandGate* command_gate;
     IOInterruptEventSource* interrupt_source;
     IOWorkLoop* workLoop;
+
+    IOTimerEventSource* poll_timer;
+
+#ifdef GOODIX_SIMULATOR
+    VoodooI2CGoodixSimulator* simulator;
+    IOTimerEventSource* simulator_timer;
+#endif
+
+    IOLock* reader_lock;
+    bool reader_pending;
+    bool reader_running;
+    bool reader_exiting;
+
+    // Records every report while tracing, and the trace waiting for the reader thread to replay it
+    VoodooI2CGoodixTraceWriter* trace_writer;
+    OSData* replay_trace;
+
+    VoodooI2CGoodixTracepoints tracepoints;
+
+    // Takes report coordinates to logical ones, and the one waiting for the reader thread to pick it up between reports
+    VoodooI2CGoodixTransform panel_transform;
+    VoodooI2CGoodixTransform next_panel_transform;
+    bool panel_transform_changed;
+
+    // When the last interrupt arrived, in nanoseconds
+    UInt64 irq_timestamp_ns;
+
+    // How long the panel takes to set the buffer status bit after an interrupt
+    VoodooI2CGoodixLatencyHistogram<GOODIX_READY_DELAY_BUCKETS, GOODIX_READY_DELAY_BUCKET_WIDTH, GOODIX_READY_DELAY_DECAY> ready_delay;
+
+    // When the reader saw the buffer status bit, and when it finished reading the report, in nanoseconds
+    UInt64 ready_timestamp_ns;
+    UInt64 read_timestamp_ns;
+
+    // Time from the interrupt to the reader thread running, and from the status bit to the end of the read
+    VoodooI2CGoodixLatencyHistogram<GOODIX_STAGE_BUCKETS, GOODIX_STAGE_BUCKET_WIDTH_FINE> wake_latency;
+    VoodooI2CGoodixLatencyHistogram<GOODIX_STAGE_BUCKETS, GOODIX_STAGE_BUCKET_WIDTH> read_latency;
     VoodooI2CGoodixEventDriver* event_driver;
 
-    struct Touch touches[GOODIX_MAX_CONTACTS];
-    int numTouches;
-    bool stylusButton1 = false;
-    bool stylusButton2 = false;
+    // Number of contacts we expect in the next report, used to size the first read
+    int predicted_touch_num;
+
+    // Whether sustained touches have switched us from interrupts to polling,
+    // or we poll all the time because the interrupt is missing or unreliable
+    bool polling;
+    bool polling_only;
+    int consecutive_touch_frames;
+    int idle_polls;
+    UInt64 last_frame_ns;
+    UInt64 mode_frames[2];
+    UInt64 mode_frame_ns[2];
+
+    // Whether the last report had contacts, and when the last report without any arrived
+    bool touch_active;
+    UInt64 last_lift_ns;
+
+    struct {
+        UInt64 read_hits;
+        UInt64 read_misses;
+        UInt64 status_polls;
+        UInt64 spurious_irqs;
+        UInt64 mode_switches;
+        UInt64 replay_frames;
+        UInt64 replay_ns;
+    } stats;
 
     /* Sends the appropriate packets to
      * initialise the device into multitouch mode
@@ -83,9 +167,6 @@ private:
      */
     void release_resources();
 
-    IOReturn goodix_read_reg(UInt16 reg, UInt8* values, size_t len);
-    IOReturn goodix_write_reg(UInt16 reg, UInt8 value);
-
     /* Reads goodix touchscreen version
      */
     IOReturn goodix_read_version();
@@ -106,28 +187,127 @@ private:
     /* Set default config values in the case of a config error */
     void set_default_config();
 
+    /* Rebuild the panel transform from the panel's orientation and size, and a calibration
+     * @calibration The "Calibration" dictionary, or NULL for none
+     *
+     * @return kIOReturnBadArgument if the calibration is out of range
+     */
+    IOReturn set_panel_transform(OSDictionary* calibration);
+
     /* Handles any interrupts that the Goodix device generates
-     * by spawning a thread that is out of the interrupt context
+     * by waking the reader thread, which runs out of the interrupt context
      */
     void interrupt_occurred(OSObject* owner, IOInterruptEventSource* src, int intCount);
 
-    /* Handles input in a threaded manner, then
-     * calls parse_goodix_report via the command gate for synchronisation
+    /* Starts the long-lived reader thread that services interrupts
+     *
+     * @return true if the thread was started
+     */
+    bool start_reader_thread();
+
+    /* Asks the reader thread to exit and waits until it has done so
+     */
+    void stop_reader_thread();
+
+    /* Signals the reader thread that a report is waiting
+     */
+    void wake_reader();
+
+    /* Body of the reader thread: sleeps until woken, then drains a report
+     */
+    void reader_thread_main();
+
+    /* Blocks the reader thread until the given uptime
+     * @deadline_ns The uptime to wake at, in nanoseconds
+     */
+    void reader_sleep_until(UInt64 deadline_ns);
+
+    /* Handles input on the reader thread, then
+     * calls goodix_process_events via the command gate for synchronisation
      */
     void handle_input_threaded();
 
+    /* Marks the current read as finished and, unless we're polling, re-enables the interrupt source
+     */
+    void rearm_interrupt();
+
+    /* Polls the panel for a report while in polling mode
+     */
+    void poll_timer_fired(OSObject* owner, IOTimerEventSource* timer);
+
+    /* The interval of the poll timer in the current state
+     *
+     * @return the interval in milliseconds
+     */
+    UInt32 poll_interval_ms();
+
+#ifdef GOODIX_SIMULATOR
+    /* Creates the simulated panel and scripts its touches
+     *
+     * @return the simulator, or NULL if it could not be allocated
+     */
+    VoodooI2CGoodixSimulator* create_simulator();
+
+    /* Delivers the simulated panel's interrupts
+     */
+    void simulator_timer_fired(OSObject* owner, IOTimerEventSource* timer);
+#endif
+
+    /* Switches between interrupt and polling mode based on the report just read
+     * @touch_num The result of goodix_ts_read_input_report
+     */
+    void update_report_mode(int touch_num);
+
+    /* Accounts a report towards the frame rate of the current mode
+     */
+    void account_frame();
+
     /* Process incoming events. Called when the IRQ is triggered.
-     * Read the current device state, and push the input events to the user space.
+     * Read the current device state, and queue the input events for the event driver.
      */
     IOReturn goodix_process_events();
 
-    /* Store the coordinate data to the array of touches that will be sent to the event driver */
-    void goodix_ts_store_touch(UInt8 *coor_data);
+    /* Update the interrupt and polling state after a read, called through the command gate
+     * @touch_num The result of goodix_ts_read_input_report
+     * @data The report that was read, which is added to the trace if one is being recorded
+     */
+    IOReturn finish_read(int* touch_num, UInt8* data);
+
+    /* Build a frame from a report and queue it for the event driver
+     * @data The report, starting with the status byte
+     * @touch_num The number of contacts in the report
+     * @timestamp When the panel signalled the report, in nanoseconds
+     * @read_timestamp When the report was read, in nanoseconds, or 0 if it was not read from the panel
+     *
+     * @return false if the event driver's queue was full and the frame was dropped
+     */
+    bool goodix_ts_report_frame(UInt8 *data, int touch_num, UInt64 timestamp, UInt64 read_timestamp);
+
+    /* Start or stop recording a trace, called through the command gate
+     * @enable Whether to record. When recording stops, the trace is published as the "Trace" property
+     */
+    IOReturn set_trace_recording(OSBoolean* enable);
 
-    /* Poll and read the input report once it's ready
+    /* Feed each report of a trace to the event driver as fast as it takes them, on the reader thread
+     * @trace The trace to replay
+     */
+    void replay(OSData* trace);
+
+    /* Blocks the reader thread until the event driver has reported enough of the queued frames
+     * @max_queued The most frames that can still be waiting, 0 to wait until all were reported
+     */
+    void wait_for_event_driver(UInt32 max_queued);
+
+    /* Wait for the input report to become ready, and read it with goodix_read_report
+     *
+     * @return the number of touches, GOODIX_REPORT_ERROR on error, or GOODIX_REPORT_NOT_READY if no report became ready
      */
     int goodix_ts_read_input_report(UInt8 *data);
 
+    /* Publish driver statistics as the "Statistics" property
+     */
+    void publish_statistics();
+
     /* Send the interrupt end command
      */
     IOReturn goodix_end_cmd();
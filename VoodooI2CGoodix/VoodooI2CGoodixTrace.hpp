@@ -0,0 +1,240 @@
+//
+//  VoodooI2CGoodixTrace.hpp
+//  VoodooI2CGoodix
+//
+//  Created by agent on 10/17/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef VoodooI2CGoodixTrace_hpp
+#define VoodooI2CGoodixTrace_hpp
+
+#include <IOKit/IOLib.h>
+#include <libkern/OSByteOrder.h>
+#include <string.h>
+#include "goodix.h"
+
+#define GOODIX_TRACE_MAGIC      0x58444F47 // "GODX"
+#define GOODIX_TRACE_VERSION    1
+#define GOODIX_TRACE_CAPACITY   (256 * 1024)
+
+// The status byte, every contact and the key byte
+#define GOODIX_TRACE_REPORT_MAX (1 + GOODIX_CONTACT_SIZE * GOODIX_MAX_CONTACTS + 1)
+
+/* A trace starts with a header, followed by one record per report:
+ *
+ *   UInt64 timestamp  nanoseconds of uptime when the panel signalled the report, little endian
+ *   UInt8  length     the number of report bytes that follow
+ *   UInt8  report[]   the status byte, the contacts and the key byte, as read from the panel
+ */
+
+struct __attribute__((packed)) VoodooI2CGoodixTraceHeader {
+    UInt32 magic;
+    UInt16 version;
+    UInt16 contactSize;
+};
+
+struct VoodooI2CGoodixTraceRecord {
+    UInt64 timestamp;
+    UInt8 length;
+    UInt8 report[GOODIX_TRACE_REPORT_MAX];
+};
+
+/* Records reports into a fixed-size buffer that is allocated when recording starts
+ */
+
+class VoodooI2CGoodixTraceWriter {
+ public:
+    VoodooI2CGoodixTraceWriter() : buffer(NULL), used(0), records(0), droppedRecords(0) {}
+
+    ~VoodooI2CGoodixTraceWriter() {
+        discard();
+    }
+
+    /* Allocate the buffer and write the header
+     *
+     * @return false if the buffer could not be allocated
+     */
+
+    bool start() {
+        discard();
+        buffer = (UInt8*)IOMalloc(GOODIX_TRACE_CAPACITY);
+        if (!buffer) {
+            return false;
+        }
+
+        VoodooI2CGoodixTraceHeader header;
+        header.magic = OSSwapHostToLittleInt32(GOODIX_TRACE_MAGIC);
+        header.version = OSSwapHostToLittleInt16(GOODIX_TRACE_VERSION);
+        header.contactSize = OSSwapHostToLittleInt16(GOODIX_CONTACT_SIZE);
+        memcpy(buffer, &header, sizeof(header));
+        used = sizeof(header);
+        records = 0;
+        droppedRecords = 0;
+        return true;
+    }
+
+    /* Append a report to the trace
+     * @timestamp When the panel signalled the report, in nanoseconds
+     * @report The report, starting with the status byte
+     * @length The length of the report
+     *
+     * @return false if the trace is full and the report was dropped
+     */
+
+    bool append(UInt64 timestamp, const UInt8* report, size_t length) {
+        if (!buffer || length > GOODIX_TRACE_REPORT_MAX) {
+            return false;
+        }
+        if (used + sizeof(timestamp) + 1 + length > GOODIX_TRACE_CAPACITY) {
+            droppedRecords++;
+            return false;
+        }
+
+        UInt64 littleTimestamp = OSSwapHostToLittleInt64(timestamp);
+        memcpy(buffer + used, &littleTimestamp, sizeof(littleTimestamp));
+        used += sizeof(littleTimestamp);
+        buffer[used++] = length;
+        memcpy(buffer + used, report, length);
+        used += length;
+        records++;
+        return true;
+    }
+
+#ifdef KERNEL
+    /* Stop recording
+     *
+     * @return the trace, or NULL if nothing was being recorded. The caller must release it.
+     */
+
+    OSData* finish() {
+        if (!buffer) {
+            return NULL;
+        }
+        OSData* trace = OSData::withBytes(buffer, (unsigned)used);
+        discard();
+        return trace;
+    }
+#endif
+
+    /* The trace recorded so far, header included, or NULL if nothing is being recorded
+     */
+
+    const UInt8* getBytes() const {
+        return buffer;
+    }
+
+    size_t getLength() const {
+        return used;
+    }
+
+    bool isRecording() const {
+        return buffer != NULL;
+    }
+
+    /* The number of records in the current trace
+     */
+
+    UInt32 getRecords() const {
+        return records;
+    }
+
+    /* The number of reports that did not fit in the current trace
+     */
+
+    UInt32 getDroppedRecords() const {
+        return droppedRecords;
+    }
+
+ private:
+    UInt8* buffer;
+    size_t used;
+    UInt32 records;
+    UInt32 droppedRecords;
+
+    void discard() {
+        if (buffer) {
+            IOFree(buffer, GOODIX_TRACE_CAPACITY);
+            buffer = NULL;
+        }
+        used = 0;
+    }
+};
+
+/* Walks the records of a trace
+ *
+ * Traces come from user space, so every record is checked before it's returned. Reading stops at
+ * the first record that is truncated, or that holds a report the panel could not have sent.
+ */
+
+class VoodooI2CGoodixTraceReader {
+ public:
+    VoodooI2CGoodixTraceReader(const UInt8* bytes, size_t length) : bytes(bytes), length(length), position(0) {
+        VoodooI2CGoodixTraceHeader header;
+        if (!bytes || length < sizeof(header)) {
+            valid = false;
+            return;
+        }
+
+        memcpy(&header, bytes, sizeof(header));
+        valid = OSSwapLittleToHostInt32(header.magic) == GOODIX_TRACE_MAGIC &&
+                OSSwapLittleToHostInt16(header.version) == GOODIX_TRACE_VERSION &&
+                OSSwapLittleToHostInt16(header.contactSize) == GOODIX_CONTACT_SIZE;
+        position = sizeof(header);
+    }
+
+    /* Whether the trace has a header this driver understands
+     */
+
+    bool isValid() const {
+        return valid;
+    }
+
+    /* Read the next record
+     * @record Receives the record
+     *
+     * @return false at the end of the trace, or at the first malformed record
+     */
+
+    bool next(VoodooI2CGoodixTraceRecord& record) {
+        if (!valid || length - position < sizeof(record.timestamp) + 1) {
+            return false;
+        }
+
+        UInt64 littleTimestamp;
+        memcpy(&littleTimestamp, bytes + position, sizeof(littleTimestamp));
+        record.timestamp = OSSwapLittleToHostInt64(littleTimestamp);
+        record.length = bytes[position + sizeof(littleTimestamp)];
+
+        size_t start = position + sizeof(littleTimestamp) + 1;
+        if (record.length < 2 || record.length > GOODIX_TRACE_REPORT_MAX || length - start < record.length) {
+            valid = false;
+            return false;
+        }
+        memcpy(record.report, bytes + start, record.length);
+
+        // The length has to match the contact count, and every contact has to fit in a frame
+        int touchNum = record.report[0] & 0x0f;
+        if (record.length != 1 + GOODIX_CONTACT_SIZE * touchNum + 1) {
+            valid = false;
+            return false;
+        }
+        for (int i = 0; i < touchNum; i++) {
+            if ((record.report[1 + i * GOODIX_CONTACT_SIZE] & 0x0f) >= GOODIX_MAX_CONTACTS) {
+                valid = false;
+                return false;
+            }
+        }
+
+        position = start + record.length;
+        return true;
+    }
+
+ private:
+    const UInt8* bytes;
+    size_t length;
+    size_t position;
+    bool valid;
+};
+
+#endif /* VoodooI2CGoodixTrace_hpp */
@@ -0,0 +1,47 @@
+//
+//  VoodooI2CGoodixTracepoints.cpp
+//  VoodooI2CGoodix
+//
+//  Created by agent on 10/17/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#include "VoodooI2CGoodixTracepoints.hpp"
+
+// In the order of VoodooI2CGoodixTraceEvent
+static const char* const formats[kGoodixTraceEventCount] = {
+    "Finger lifted",
+    "Stylus hovering at %d, %d",
+    "Stylus right click at %d, %d",
+    "Stylus left click at %d, %d",
+    "Gesture state %d -> %d on event %d at %d, %d",
+    "Starting scroll",
+    "Handling multitouch with %d fingers",
+    "Blocking phantom single touch interaction",
+    "Touch %d with width %d at %d,%d",
+    "Stylus %d with width %d at %d,%d"
+};
+
+void VoodooI2CGoodixTracepoints::dump(const char* name) const {
+    UInt32 end = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+    UInt32 start = end > GOODIX_TRACEPOINT_RING_SIZE ? end - GOODIX_TRACEPOINT_RING_SIZE : 0;
+    char message[128];
+
+    IOLog("%s::Dumping %u tracepoints\n", name, end - start);
+    for (UInt32 i = start; i != end; i++) {
+        Tracepoint tracepoint = slots[i & (GOODIX_TRACEPOINT_RING_SIZE - 1)];
+
+        // The writer may have lapped us while we copied this one
+        if (__atomic_load_n(&head, __ATOMIC_ACQUIRE) - i >= GOODIX_TRACEPOINT_RING_SIZE) {
+            continue;
+        }
+        if (tracepoint.event >= kGoodixTraceEventCount) {
+            continue;
+        }
+
+        UInt64 nanoseconds;
+        absolutetime_to_nanoseconds(tracepoint.time, &nanoseconds);
+        snprintf(message, sizeof(message), formats[tracepoint.event], tracepoint.args[0], tracepoint.args[1], tracepoint.args[2], tracepoint.args[3], tracepoint.args[4]);
+        IOLog("%s::[%llu.%06llu] %s\n", name, nanoseconds / 1000000000, nanoseconds / 1000 % 1000000, message);
+    }
+}
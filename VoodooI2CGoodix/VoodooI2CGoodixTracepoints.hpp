@@ -0,0 +1,101 @@
+//
+//  VoodooI2CGoodixTracepoints.hpp
+//  VoodooI2CGoodix
+//
+//  Created by agent on 10/17/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef VoodooI2CGoodixTracepoints_hpp
+#define VoodooI2CGoodixTracepoints_hpp
+
+#include <IOKit/IOLib.h>
+
+#define GOODIX_TRACEPOINT_RING_SIZE 256
+
+/* Categories of tracepoints, each can be enabled at runtime with the TraceCategories property */
+enum {
+    kGoodixTraceCategoryClick      = 1 << 0,
+    kGoodixTraceCategoryLift       = 1 << 1,
+    kGoodixTraceCategoryHover      = 1 << 2,
+    kGoodixTraceCategoryDrag       = 1 << 3,
+    kGoodixTraceCategoryGesture    = 1 << 4,
+    kGoodixTraceCategoryContact    = 1 << 5
+};
+
+/* Every tracepoint, its message is only formatted when the ring is dumped */
+enum VoodooI2CGoodixTraceEvent {
+    kGoodixTraceFingerLift,
+    kGoodixTraceStylusHover,
+    kGoodixTraceStylusRightClick,
+    kGoodixTraceStylusLeftClick,
+    kGoodixTraceGestureTransition,
+    kGoodixTraceBeginScroll,
+    kGoodixTraceMultitouch,
+    kGoodixTracePhantomTouch,
+    kGoodixTraceFingerContact,
+    kGoodixTraceStylusContact,
+    kGoodixTraceEventCount
+};
+
+/* A ring of binary tracepoints that keeps the most recent GOODIX_TRACEPOINT_RING_SIZE of them
+ *
+ * Recording a tracepoint takes no locks and does no formatting, so tracepoints can stay in the
+ * per-frame path. Each instance must only be recorded to from one thread at a time; dumping
+ * is safe from any thread, and skips tracepoints that were overwritten while they were copied.
+ */
+
+class VoodooI2CGoodixTracepoints {
+ public:
+    VoodooI2CGoodixTracepoints() : head(0), categories(0) {}
+
+    /* Enable tracepoints by category
+     * @mask The kGoodixTraceCategory* categories to enable, all others are disabled
+     */
+
+    void setCategories(UInt32 mask) {
+        __atomic_store_n(&categories, mask, __ATOMIC_RELAXED);
+    }
+
+    /* Record a tracepoint if its category is enabled
+     * @category The kGoodixTraceCategory* category of the tracepoint
+     * @event The tracepoint
+     * @a-@e The arguments of the tracepoint's message
+     */
+
+    inline void record(UInt32 category, VoodooI2CGoodixTraceEvent event, SInt32 a = 0, SInt32 b = 0, SInt32 c = 0, SInt32 d = 0, SInt32 e = 0) {
+        if (!(__atomic_load_n(&categories, __ATOMIC_RELAXED) & category)) {
+            return;
+        }
+
+        UInt32 currentHead = __atomic_load_n(&head, __ATOMIC_RELAXED);
+        Tracepoint& tracepoint = slots[currentHead & (GOODIX_TRACEPOINT_RING_SIZE - 1)];
+        clock_get_uptime(&tracepoint.time);
+        tracepoint.event = event;
+        tracepoint.args[0] = a;
+        tracepoint.args[1] = b;
+        tracepoint.args[2] = c;
+        tracepoint.args[3] = d;
+        tracepoint.args[4] = e;
+        __atomic_store_n(&head, currentHead + 1, __ATOMIC_RELEASE);
+    }
+
+    /* Format and log the tracepoints in the ring, oldest first
+     * @name The name of the driver the tracepoints belong to
+     */
+
+    void dump(const char* name) const;
+
+ private:
+    struct Tracepoint {
+        AbsoluteTime time;
+        VoodooI2CGoodixTraceEvent event;
+        SInt32 args[5];
+    };
+
+    Tracepoint slots[GOODIX_TRACEPOINT_RING_SIZE];
+    UInt32 head;
+    UInt32 categories;
+};
+
+#endif /* VoodooI2CGoodixTracepoints_hpp */
@@ -0,0 +1,152 @@
+//
+//  VoodooI2CGoodixTransform.hpp
+//  VoodooI2CGoodix
+//
+//  Created by agent on 10/17/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef VoodooI2CGoodixTransform_hpp
+#define VoodooI2CGoodixTransform_hpp
+
+#include <libkern/OSTypes.h>
+
+#define GOODIX_TRANSFORM_ONE    (1LL << 32)
+
+/* An integer affine transform with 32.32 fixed point coefficients
+ *
+ *   x' = floor(xx * x + xy * y + x0)
+ *   y' = floor(yx * x + yy * y + y0)
+ *
+ * Transforms are built from the steps below and combined with <then> when one of their inputs
+ * changes, so applying one to a contact is four multiplies. The input has to be within the range
+ * the transform was built for, e.g. 0 to the panel's size, for the products to fit in 64 bits.
+ * A transform can also clamp its output, for steps like a user calibration that can move
+ * coordinates off the panel.
+ */
+
+class VoodooI2CGoodixTransform {
+ public:
+    VoodooI2CGoodixTransform() : xx(GOODIX_TRANSFORM_ONE), xy(0), yx(0), yy(GOODIX_TRANSFORM_ONE), x0(0), y0(0), clamped(false), maxX(0), maxY(0) {}
+
+    /* Exchange X and Y
+     */
+
+    static VoodooI2CGoodixTransform swapAxes() {
+        return VoodooI2CGoodixTransform(0, GOODIX_TRANSFORM_ONE, GOODIX_TRANSFORM_ONE, 0, 0, 0);
+    }
+
+    /* Mirror X and/or Y within 0 to max
+     */
+
+    static VoodooI2CGoodixTransform invert(bool invertX, bool invertY, int maxX, int maxY) {
+        VoodooI2CGoodixTransform transform;
+        if (invertX) {
+            transform.xx = -GOODIX_TRANSFORM_ONE;
+            transform.x0 = maxX * GOODIX_TRANSFORM_ONE;
+        }
+        if (invertY) {
+            transform.yy = -GOODIX_TRANSFORM_ONE;
+            transform.y0 = maxY * GOODIX_TRANSFORM_ONE;
+        }
+        return transform;
+    }
+
+    /* Scale 0 to maxX and 0 to maxY to 0 to extent
+     *
+     * The multipliers are rounded up, so the result is extent * x / maxX in integer math for any
+     * max under 65536.
+     */
+
+    static VoodooI2CGoodixTransform scaleTo(int maxX, int maxY, int extent) {
+        VoodooI2CGoodixTransform transform;
+        transform.xx = maxX > 0 ? (extent * GOODIX_TRANSFORM_ONE + maxX - 1) / maxX : 0;
+        transform.yy = maxY > 0 ? (extent * GOODIX_TRANSFORM_ONE + maxY - 1) / maxY : 0;
+        return transform;
+    }
+
+    /* Rotate 0 to maxX and 0 to maxY like a display, then scale the rotated axes to 0 to extent
+     * @swap Exchange X and Y first, maxX and maxY are the sizes before the swap
+     * @invertX, @invertY Mirror the axes after the swap
+     *
+     * The rotation is done on the integer input, so scaling is the only step that rounds and
+     * every input in range maps to 0 to extent.
+     */
+
+    static VoodooI2CGoodixTransform rotateAndScale(int maxX, int maxY, bool swap, bool invertX, bool invertY, int extent) {
+        VoodooI2CGoodixTransform transform;
+        if (swap) {
+            transform = swapAxes();
+            int swappedMaxX = maxY;
+            maxY = maxX;
+            maxX = swappedMaxX;
+        }
+        return transform.then(invert(invertX, invertY, maxX, maxY)).then(scaleTo(maxX, maxY, extent));
+    }
+
+    /* A user calibration
+     * @scaleX, @skewX, @skewY, @scaleY The linear part, in 16.16 fixed point like IOFixed
+     * @offsetX, @offsetY Added after scaling, in output units
+     */
+
+    static VoodooI2CGoodixTransform calibration(SInt32 scaleX, SInt32 skewX, SInt32 skewY, SInt32 scaleY, SInt32 offsetX, SInt32 offsetY) {
+        return VoodooI2CGoodixTransform((SInt64)scaleX << 16, (SInt64)skewX << 16, (SInt64)skewY << 16, (SInt64)scaleY << 16,
+                                        offsetX * GOODIX_TRANSFORM_ONE, offsetY * GOODIX_TRANSFORM_ONE);
+    }
+
+    /* This transform followed by another one
+     * @next The transform to apply to the result of this one
+     */
+
+    VoodooI2CGoodixTransform then(const VoodooI2CGoodixTransform& next) const {
+        VoodooI2CGoodixTransform transform(
+            multiply(next.xx, xx) + multiply(next.xy, yx),
+            multiply(next.xx, xy) + multiply(next.xy, yy),
+            multiply(next.yx, xx) + multiply(next.yy, yx),
+            multiply(next.yx, xy) + multiply(next.yy, yy),
+            multiply(next.xx, x0) + multiply(next.xy, y0) + next.x0,
+            multiply(next.yx, x0) + multiply(next.yy, y0) + next.y0
+        );
+
+        // Only the last step's clamp is kept, this one's output isn't clamped anymore
+        transform.clamped = next.clamped;
+        transform.maxX = next.maxX;
+        transform.maxY = next.maxY;
+        return transform;
+    }
+
+    /* This transform with its output clamped to 0 to max
+     */
+
+    VoodooI2CGoodixTransform clampedTo(int newMaxX, int newMaxY) const {
+        VoodooI2CGoodixTransform transform = *this;
+        transform.clamped = true;
+        transform.maxX = newMaxX;
+        transform.maxY = newMaxY;
+        return transform;
+    }
+
+    inline void apply(int x, int y, int* outX, int* outY) const {
+        *outX = (int)((xx * x + xy * y + x0) >> 32);
+        *outY = (int)((yx * x + yy * y + y0) >> 32);
+        if (clamped) {
+            *outX = *outX < 0 ? 0 : (*outX > maxX ? maxX : *outX);
+            *outY = *outY < 0 ? 0 : (*outY > maxY ? maxY : *outY);
+        }
+    }
+
+ private:
+    SInt64 xx, xy, yx, yy;
+    SInt64 x0, y0;
+    bool clamped;
+    int maxX, maxY;
+
+    VoodooI2CGoodixTransform(SInt64 xx, SInt64 xy, SInt64 yx, SInt64 yy, SInt64 x0, SInt64 y0) : xx(xx), xy(xy), yx(yx), yy(yy), x0(x0), y0(y0), clamped(false), maxX(0), maxY(0) {}
+
+    // Only used when a transform is built, so the 128 bit product stays out of the per-contact path
+    static SInt64 multiply(SInt64 a, SInt64 b) {
+        return (SInt64)(((__int128)a * b) >> 32);
+    }
+};
+
+#endif /* VoodooI2CGoodixTransform_hpp */
@@ -0,0 +1,124 @@
+//
+//  VoodooI2CGoodixTransport.hpp
+//  VoodooI2CGoodix
+//
+//  Created by agent on 10/17/26.
+//  Copyright © 2026 agent. All rights reserved.
+//
+
+#ifndef VoodooI2CGoodixTransport_hpp
+#define VoodooI2CGoodixTransport_hpp
+
+#include <libkern/OSTypes.h>
+#include <IOKit/IOReturn.h>
+#include <string.h>
+
+#include "goodix.h"
+
+/* The bus operations the Goodix protocol is built on
+ *
+ * The driver only talks to the panel through this interface, so the protocol logic
+ * doesn't depend on how the bytes get to and from the controller.
+ */
+
+class VoodooI2CGoodixTransport {
+ public:
+    virtual ~VoodooI2CGoodixTransport() {}
+
+    /* Read the product ID and firmware version block at GOODIX_REG_ID
+     * @values Receives the block
+     * @len The number of bytes to read
+     */
+
+    virtual IOReturn readVersion(UInt8* values, size_t len) = 0;
+
+    /* Read the configuration block
+     * @reg The address of the block, which depends on the chip
+     * @values Receives the block
+     * @len The number of bytes to read
+     */
+
+    virtual IOReturn readConfig(UInt16 reg, UInt8* values, size_t len) = 0;
+
+    /* Read part of the coordinate report
+     * @offset The offset from GOODIX_READ_COOR_ADDR to start reading at
+     * @values Receives the bytes
+     * @len The number of bytes to read
+     */
+
+    virtual IOReturn readReport(UInt16 offset, UInt8* values, size_t len) = 0;
+
+    /* Clear the buffer status so the panel can prepare the next report
+     */
+
+    virtual IOReturn endCmd() = 0;
+};
+
+/* A transport backed by an in-memory copy of the panel's registers
+ *
+ * Nothing changes a register unless the owner does, which makes it a fixed fake panel.
+ */
+
+#define GOODIX_REGISTER_BASE    0x8040
+#define GOODIX_REGISTER_COUNT   0x200
+
+class VoodooI2CGoodixMemoryTransport : public VoodooI2CGoodixTransport {
+ public:
+    VoodooI2CGoodixMemoryTransport() {
+        memset(registers, 0, sizeof(registers));
+    }
+
+    IOReturn readVersion(UInt8* values, size_t len) override {
+        return readRegisters(GOODIX_REG_ID, values, len);
+    }
+
+    IOReturn readConfig(UInt16 reg, UInt8* values, size_t len) override {
+        return readRegisters(reg, values, len);
+    }
+
+    IOReturn readReport(UInt16 offset, UInt8* values, size_t len) override {
+        return readRegisters(GOODIX_READ_COOR_ADDR + offset, values, len);
+    }
+
+    IOReturn endCmd() override {
+        UInt8 zero = 0;
+        return writeRegisters(GOODIX_READ_COOR_ADDR, &zero, 1);
+    }
+
+    /* Copy bytes out of the register map
+     * @reg The first register to read
+     * @values Receives the bytes
+     * @len The number of bytes to read
+     */
+
+    IOReturn readRegisters(UInt16 reg, UInt8* values, size_t len) {
+        if (!inRange(reg, len)) {
+            return kIOReturnBadArgument;
+        }
+        memcpy(values, &registers[reg - GOODIX_REGISTER_BASE], len);
+        return kIOReturnSuccess;
+    }
+
+    /* Copy bytes into the register map
+     * @reg The first register to write
+     * @values The bytes to write
+     * @len The number of bytes to write
+     */
+
+    IOReturn writeRegisters(UInt16 reg, const UInt8* values, size_t len) {
+        if (!inRange(reg, len)) {
+            return kIOReturnBadArgument;
+        }
+        memcpy(&registers[reg - GOODIX_REGISTER_BASE], values, len);
+        return kIOReturnSuccess;
+    }
+
+ protected:
+    UInt8 registers[GOODIX_REGISTER_COUNT];
+
+    bool inRange(UInt16 reg, size_t len) const {
+        return reg >= GOODIX_REGISTER_BASE && reg - GOODIX_REGISTER_BASE + len <= GOODIX_REGISTER_COUNT;
+    }
+};
+
+#endif /* VoodooI2CGoodixTransport_hpp */
@@ -18,6 +18,9 @@
 #define GOODIX_CONTACT_SIZE     8
 #define GOODIX_MAX_CONTACTS     10
 
+/* Frames queued between the touch driver and the event driver, must be a power of two */
+#define GOODIX_FRAME_RING_SIZE  8
+
 #define RESOLUTION_LOC          1
 #define MAX_CONTACTS_LOC        5
 #define TRIGGER_LOC             6
@@ -31,6 +34,45 @@
 #define GOODIX_BUFFER_STATUS_READY      BIT(7)
 #define GOODIX_BUFFER_STATUS_TIMEOUT    20000000
 
+/* Hybrid interrupt/polling mode */
+#define GOODIX_POLL_SWITCH_FRAMES       8
+#define GOODIX_POLL_IDLE_LIMIT          3
+#define GOODIX_FRAME_RATE_MAX_GAP       100000000
+#define GOODIX_DEFAULT_REFRESH_INTERVAL 10
+#define GOODIX_IDLE_POLL_INTERVAL       50
+
+/* Without an interrupt, the idle poll interval doubles after every run of this many empty polls, up to the maximum (ms) */
+#define GOODIX_IDLE_POLL_BACKOFF        20
+#define GOODIX_IDLE_POLL_INTERVAL_MAX   200
+
+/* The panel reports every 5 + N ms, where N is the low nibble of the refresh config */
+#define GOODIX_REFRESH_INTERVAL(refresh) \
+    (5 + ((refresh) & 0x0f))
+
+/* Returned instead of a touch count when a transfer failed, no report became ready, or the report was malformed */
+#define GOODIX_REPORT_ERROR             -1
+#define GOODIX_REPORT_NOT_READY         -2
+#define GOODIX_REPORT_INVALID           -3
+
+/* Buffer-ready polling, all values in microseconds */
+#define GOODIX_POLL_INTERVAL                1000
+#define GOODIX_POLL_INTERVAL_FINE           250
+#define GOODIX_READY_DELAY_BUCKET_WIDTH     250
+#define GOODIX_READY_DELAY_BUCKETS          (GOODIX_BUFFER_STATUS_TIMEOUT / 1000 / GOODIX_READY_DELAY_BUCKET_WIDTH)
+#define GOODIX_READY_DELAY_MIN_SAMPLES      16
+#define GOODIX_READY_DELAY_DECAY            256
+#define GOODIX_READY_DELAY_PERCENTILE       5
+
+/* How long after a lift report an interrupt may be spurious (ns), and how late its buffer may become ready (percentile) */
+#define GOODIX_SPURIOUS_IRQ_WINDOW          100000000
+#define GOODIX_SPURIOUS_IRQ_PERCENTILE      99
+
+/* Per-stage latency histograms, bucket widths in microseconds */
+#define GOODIX_STAGE_BUCKETS                128
+#define GOODIX_STAGE_BUCKET_WIDTH_FINE      10
+#define GOODIX_STAGE_BUCKET_WIDTH           25
+#define GOODIX_STAGE_BUCKET_WIDTH_COARSE    250
+
 #define GOODIX_STYLUS_BTN1  0
 #define GOODIX_STYLUS_BTN2  1
 